@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "rand.h"
+#include "scenes/board/bitboard.h"
+
+// Checks that the column drop used for the ghost piece and hard drops lands every piece
+// in the same place as stepping it down row by row.
+//
+//   pwb-dropcheck [positions] [seed]
+//
+// Drops pieces from random positions on random playfields with overhangs and holes.
+// Exits with a non-zero status if any landing differs.
+
+#define DEFAULT_POSITIONS 330000
+
+// Fill the playfield up to a random height. Rows get sparser towards the top so pieces have
+// overhangs to slide under as well as a surface to land on
+static void randomBoard(Bitboard board, unsigned int* rng) {
+    bitboardClear(board);
+
+    *rng = rand_advance(*rng);
+
+    int height = (int)((*rng >> 8) % (MATRIX_GRID_ROWS - 3));
+
+    for (int row = MATRIX_GRID_ROWS - height; row < MATRIX_GRID_ROWS; row++) {
+        *rng = rand_advance(*rng);
+        BitboardRow cells = (BitboardRow)(*rng >> 8) & BITBOARD_FULL_ROW;
+
+        *rng = rand_advance(*rng);
+
+        // Rows near the bottom are mostly filled
+        if (((*rng >> 8) % (unsigned int)MATRIX_GRID_ROWS) < (unsigned int)(row - (MATRIX_GRID_ROWS - height))) {
+            cells |= (BitboardRow)(*rng >> 12) & BITBOARD_FULL_ROW;
+        }
+
+        board[row] = cells;
+    }
+}
+
+int main(int argc, char** argv) {
+    long numPositions = argc > 1 ? atol(argv[1]) : DEFAULT_POSITIONS;
+    unsigned int rng = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 0) : 1;
+
+    if (numPositions <= 0) {
+        fprintf(stderr, "Usage: %s [positions] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    bitboardInit();
+
+    Bitboard board;
+    BitboardColumns columns;
+    long checked = 0;
+    long mismatches = 0;
+
+    while (checked < numPositions) {
+        randomBoard(board, &rng);
+        bitboardBuildColumns(board, columns);
+
+        // Several pieces per playfield. Positions the piece doesn't fit in aren't valid drops and are skipped
+        for (int attempt = 0; attempt < 64 && checked < numPositions; attempt++) {
+            rng = rand_advance(rng);
+
+            Piece piece = (Piece)(O + (int)((rng >> 8) % 7));
+            Position pos = {
+                .row = (int)((rng >> 12) % MATRIX_GRID_ROWS),
+                .col = (int)((rng >> 20) % (MATRIX_GRID_COLS + 2)) - 2,
+                .orientation = (int)((rng >> 28) % 4)
+            };
+
+            if (!bitboardPieceFits(board, piece, pos)) {
+                continue;
+            }
+
+            Position expected = bitboardDropPosition(board, piece, pos);
+            Position actual = bitboardColumnsDropPosition(columns, piece, pos);
+
+            if (expected.row != actual.row || expected.col != actual.col || expected.orientation != actual.orientation) {
+                if (mismatches < 10) {
+                    fprintf(stderr, "Piece %d at row %d col %d orientation %d lands on row %d but the column drop gives row %d\n",
+                        piece, pos.row, pos.col, pos.orientation, expected.row, actual.row);
+                }
+
+                mismatches++;
+            }
+
+            checked++;
+        }
+    }
+
+    printf("%ld positions checked, %ld mismatched\n", checked, mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,637 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "env.h"
+#include "rand.h"
+
+// Alignment of every state array, so each one starts on its own cache line
+#define ENV_ARRAY_ALIGNMENT 64
+
+typedef struct EnvWorker {
+    struct EnvPool* pool;
+    int index;
+} EnvWorker;
+
+// Worker threads that step a share of the boards each frame
+struct EnvPool {
+    pthread_t* threads;
+    EnvWorker* workers;
+    int numThreads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t startCond;
+    pthread_cond_t doneCond;
+
+    // Bumped every step so workers know there's new work
+    unsigned int generation;
+    int pending;
+    bool quit;
+
+    // Inputs for the step in progress
+    const uint8_t* current;
+    const uint8_t* pushed;
+
+    Env* env;
+};
+
+// Allocate one state array
+static void* allocArray(int numBoards, size_t elementSize) {
+    size_t size = (size_t)numBoards * elementSize;
+
+    // aligned_alloc requires a size that's a multiple of the alignment
+    size = (size + ENV_ARRAY_ALIGNMENT - 1) / ENV_ARRAY_ALIGNMENT * ENV_ARRAY_ALIGNMENT;
+
+    void* array = aligned_alloc(ENV_ARRAY_ALIGNMENT, size);
+
+    if (array != NULL) {
+        memset(array, 0, size);
+    }
+
+    return array;
+}
+
+// Boards [first, last) handled by a worker
+static void shardRange(const Env* env, int numThreads, int index, int* first, int* last) {
+    int perThread = (env->numBoards + numThreads - 1) / numThreads;
+    perThread = (perThread + ENV_SHARD_ALIGNMENT - 1) / ENV_SHARD_ALIGNMENT * ENV_SHARD_ALIGNMENT;
+
+    *first = index * perThread;
+    *last = *first + perThread;
+
+    if (*first > env->numBoards) {
+        *first = env->numBoards;
+    }
+
+    if (*last > env->numBoards) {
+        *last = env->numBoards;
+    }
+}
+
+static void* workerMain(void* data) {
+    EnvWorker* worker = (EnvWorker*)data;
+    EnvPool* pool = worker->pool;
+    unsigned int seenGeneration = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+
+        while (!pool->quit && pool->generation == seenGeneration) {
+            pthread_cond_wait(&pool->startCond, &pool->lock);
+        }
+
+        if (pool->quit) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+
+        seenGeneration = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        int first;
+        int last;
+        shardRange(pool->env, pool->numThreads + 1, worker->index, &first, &last);
+
+        envStepRange(pool->env, first, last, pool->current, pool->pushed);
+
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->doneCond);
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+static void destroyPool(EnvPool* pool);
+
+// Start the worker threads. The calling thread always takes the first shard, so numThreads - 1 are created
+// Returns NULL if the pool couldn't be allocated or a thread couldn't be started
+static EnvPool* createPool(Env* env, int numThreads) {
+    EnvPool* pool = calloc(1, sizeof(EnvPool));
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->env = env;
+    pool->numThreads = numThreads - 1;
+    pool->threads = calloc(pool->numThreads, sizeof(pthread_t));
+    pool->workers = calloc(pool->numThreads, sizeof(EnvWorker));
+
+    if (pool->threads == NULL || pool->workers == NULL) {
+        free(pool->threads);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->startCond, NULL);
+    pthread_cond_init(&pool->doneCond, NULL);
+
+    for (int i = 0; i < pool->numThreads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i + 1;
+
+        // Stop the threads already started. Only they are joined
+        if (pthread_create(&pool->threads[i], NULL, workerMain, &pool->workers[i]) != 0) {
+            pool->numThreads = i;
+            destroyPool(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+static void destroyPool(EnvPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->startCond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->numThreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->startCond);
+    pthread_cond_destroy(&pool->doneCond);
+
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+}
+
+// Create a batch of boards. Boards are stepped on numThreads threads (including the caller)
+// All boards start reset with seed 0 at difficulty 0
+Env* envCreate(int numBoards, int numThreads) {
+    Env* env = calloc(1, sizeof(Env));
+
+    if (env == NULL) {
+        return NULL;
+    }
+
+    bitboardInit();
+
+    env->numBoards = numBoards;
+    env->rows = allocArray(numBoards, sizeof(Bitboard));
+    env->rng = allocArray(numBoards, sizeof(uint32_t));
+    env->status = allocArray(numBoards, sizeof(uint8_t));
+    env->statusFrames = allocArray(numBoards, sizeof(uint32_t));
+    env->piece = allocArray(numBoards, sizeof(int8_t));
+    env->standbyPiece = allocArray(numBoards, sizeof(int8_t));
+    env->pieceRow = allocArray(numBoards, sizeof(int8_t));
+    env->pieceCol = allocArray(numBoards, sizeof(int8_t));
+    env->pieceOrientation = allocArray(numBoards, sizeof(int8_t));
+    env->gravityFrames = allocArray(numBoards, sizeof(uint16_t));
+    env->dasKey = allocArray(numBoards, sizeof(uint8_t));
+    env->dasCharged = allocArray(numBoards, sizeof(uint8_t));
+    env->dasFrames = allocArray(numBoards, sizeof(int32_t));
+    env->softDropInitiated = allocArray(numBoards, sizeof(uint8_t));
+    env->softDropStartingRow = allocArray(numBoards, sizeof(int8_t));
+    env->hardDropInitiated = allocArray(numBoards, sizeof(uint8_t));
+    env->hardDropStartingRow = allocArray(numBoards, sizeof(int8_t));
+    env->completedRows = allocArray(numBoards, sizeof(uint32_t));
+    env->initialDifficulty = allocArray(numBoards, sizeof(int16_t));
+    env->difficulty = allocArray(numBoards, sizeof(int16_t));
+    env->completedLines = allocArray(numBoards, sizeof(int32_t));
+    env->score = allocArray(numBoards, sizeof(int32_t));
+    env->frames = allocArray(numBoards, sizeof(uint32_t));
+    env->pieces = allocArray(numBoards, sizeof(uint32_t));
+
+    bool allocated = env->rows != NULL && env->rng != NULL && env->status != NULL && env->statusFrames != NULL
+        && env->piece != NULL && env->standbyPiece != NULL && env->pieceRow != NULL && env->pieceCol != NULL
+        && env->pieceOrientation != NULL && env->gravityFrames != NULL && env->dasKey != NULL && env->dasCharged != NULL
+        && env->dasFrames != NULL && env->softDropInitiated != NULL && env->softDropStartingRow != NULL
+        && env->hardDropInitiated != NULL && env->hardDropStartingRow != NULL && env->completedRows != NULL
+        && env->initialDifficulty != NULL && env->difficulty != NULL && env->completedLines != NULL
+        && env->score != NULL && env->frames != NULL && env->pieces != NULL;
+
+    if (!allocated) {
+        envDestroy(env);
+        return NULL;
+    }
+
+    for (int i = 0; i < numBoards; i++) {
+        envReset(env, i, 0, 0);
+    }
+
+    if (numThreads > 1) {
+        env->pool = createPool(env, numThreads);
+
+        if (env->pool == NULL) {
+            envDestroy(env);
+            return NULL;
+        }
+    }
+
+    return env;
+}
+
+// Start a new game on a board
+void envReset(Env* env, int board, unsigned int seed, int initialDifficulty) {
+    bitboardClear(&env->rows[board * BITBOARD_STRIDE]);
+
+    env->rng[board] = seed;
+    env->status[board] = Start;
+    env->statusFrames[board] = 0;
+    env->piece[board] = None;
+    env->standbyPiece[board] = None;
+    env->pieceRow[board] = 0;
+    env->pieceCol[board] = 0;
+    env->pieceOrientation[board] = 0;
+    env->gravityFrames[board] = rulesGravityFramesForDifficulty(initialDifficulty);
+    env->dasKey[board] = 0;
+    env->dasCharged[board] = false;
+    env->dasFrames[board] = 0;
+    env->softDropInitiated[board] = false;
+    env->softDropStartingRow[board] = 0;
+    env->hardDropInitiated[board] = false;
+    env->hardDropStartingRow[board] = 0;
+    env->completedRows[board] = 0;
+    env->initialDifficulty[board] = initialDifficulty;
+    env->difficulty[board] = initialDifficulty;
+    env->completedLines[board] = 0;
+    env->score[board] = 0;
+    env->frames[board] = 0;
+    env->pieces[board] = 0;
+}
+
+// Copy a board's state into a snapshot
+void envSnapshot(const Env* env, int board, EnvSnapshot* snapshot) {
+    memcpy(snapshot->rows, &env->rows[board * BITBOARD_STRIDE], sizeof(snapshot->rows));
+
+    snapshot->rng = env->rng[board];
+    snapshot->statusFrames = env->statusFrames[board];
+    snapshot->completedRows = env->completedRows[board];
+    snapshot->frames = env->frames[board];
+    snapshot->pieces = env->pieces[board];
+    snapshot->dasFrames = env->dasFrames[board];
+    snapshot->completedLines = env->completedLines[board];
+    snapshot->score = env->score[board];
+    snapshot->gravityFrames = env->gravityFrames[board];
+    snapshot->initialDifficulty = env->initialDifficulty[board];
+    snapshot->difficulty = env->difficulty[board];
+    snapshot->status = env->status[board];
+    snapshot->dasKey = env->dasKey[board];
+    snapshot->dasCharged = env->dasCharged[board];
+    snapshot->softDropInitiated = env->softDropInitiated[board];
+    snapshot->hardDropInitiated = env->hardDropInitiated[board];
+    snapshot->piece = env->piece[board];
+    snapshot->standbyPiece = env->standbyPiece[board];
+    snapshot->pieceRow = env->pieceRow[board];
+    snapshot->pieceCol = env->pieceCol[board];
+    snapshot->pieceOrientation = env->pieceOrientation[board];
+    snapshot->softDropStartingRow = env->softDropStartingRow[board];
+    snapshot->hardDropStartingRow = env->hardDropStartingRow[board];
+}
+
+// Put a board back to the state held in a snapshot
+void envRestore(Env* env, int board, const EnvSnapshot* snapshot) {
+    memcpy(&env->rows[board * BITBOARD_STRIDE], snapshot->rows, sizeof(snapshot->rows));
+
+    env->rng[board] = snapshot->rng;
+    env->statusFrames[board] = snapshot->statusFrames;
+    env->completedRows[board] = snapshot->completedRows;
+    env->frames[board] = snapshot->frames;
+    env->pieces[board] = snapshot->pieces;
+    env->dasFrames[board] = snapshot->dasFrames;
+    env->completedLines[board] = snapshot->completedLines;
+    env->score[board] = snapshot->score;
+    env->gravityFrames[board] = snapshot->gravityFrames;
+    env->initialDifficulty[board] = snapshot->initialDifficulty;
+    env->difficulty[board] = snapshot->difficulty;
+    env->status[board] = snapshot->status;
+    env->dasKey[board] = snapshot->dasKey;
+    env->dasCharged[board] = snapshot->dasCharged;
+    env->softDropInitiated[board] = snapshot->softDropInitiated;
+    env->hardDropInitiated[board] = snapshot->hardDropInitiated;
+    env->piece[board] = snapshot->piece;
+    env->standbyPiece[board] = snapshot->standbyPiece;
+    env->pieceRow[board] = snapshot->pieceRow;
+    env->pieceCol[board] = snapshot->pieceCol;
+    env->pieceOrientation[board] = snapshot->pieceOrientation;
+    env->softDropStartingRow[board] = snapshot->softDropStartingRow;
+    env->hardDropStartingRow[board] = snapshot->hardDropStartingRow;
+}
+
+// Change current status and reset status frame counter
+static inline void changeStatus(Env* env, int i, Status status) {
+    env->status[i] = status;
+    env->statusFrames[i] = 0;
+}
+
+static inline Position piecePosition(const Env* env, int i) {
+    return (Position){
+        .row = env->pieceRow[i],
+        .col = env->pieceCol[i],
+        .orientation = env->pieceOrientation[i]
+    };
+}
+
+// Updates the DAS counters
+static inline void updateDasCounts(Env* env, int i, uint8_t buttons) {
+    // Track if/how long the right or left button is held for DAS
+    if ((buttons & (ENV_BUTTON_LEFT | ENV_BUTTON_RIGHT)) > 0) {
+        int pressedKey = (buttons & ENV_BUTTON_LEFT) == ENV_BUTTON_LEFT
+            ? ENV_BUTTON_LEFT
+            : ENV_BUTTON_RIGHT;
+
+        // Reset DAS count if different key pressed
+        // Else increment
+        if (pressedKey != env->dasKey[i]) {
+            env->dasKey[i] = pressedKey;
+            env->dasFrames[i] = 1;
+            env->dasCharged[i] = false;
+        } else {
+            env->dasFrames[i]++;
+
+            if (!env->dasCharged[i] && env->dasFrames[i] == DAS_CHARGE_DELAY) {
+                env->dasCharged[i] = true;
+                env->dasFrames[i] = 0;
+            }
+        }
+    } else {
+        // Reset everything if left or right isn't currently pressed
+        env->dasKey[i] = 0;
+        env->dasFrames[i] = 0;
+        env->dasCharged[i] = false;
+    }
+}
+
+// Check the DAS state if a key can be repeated.
+// Resets frame count if a repeat is available
+static inline int dasRepeatCheck(Env* env, int i) {
+    if (env->dasCharged[i] && env->dasFrames[i] >= DAS_REPEAT_DELAY) {
+        env->dasFrames[i] = 0;
+
+        return env->dasKey[i];
+    }
+
+    return 0;
+}
+
+// Picks pieces and places the player piece at the top of the matrix
+static void stepStart(Env* env, int i, const Bitboard board) {
+    // On the first time this is called both player and standby pieces need to be picked
+    if (env->standbyPiece[i] != None) {
+        env->piece[i] = env->standbyPiece[i];
+    } else {
+        env->rng[i] = rand_advance(env->rng[i]);
+        env->piece[i] = env->rng[i] % 7;
+    }
+
+    env->rng[i] = rand_advance(env->rng[i]);
+    env->standbyPiece[i] = env->rng[i] % 7;
+
+    env->pieceRow[i] = 0;
+    env->pieceCol[i] = SPAWN_COL;
+    env->pieceOrientation[i] = SPAWN_ORIENTATION;
+
+    // A top out occurs when the player piece's starting position overlaps a piece on the board
+    if (!bitboardPieceFits(board, env->piece[i], piecePosition(env, i))) {
+        changeStatus(env, i, TopOut);
+    } else {
+        env->difficulty[i] = rulesDifficultyForLines(env->initialDifficulty[i], env->completedLines[i]);
+        env->gravityFrames[i] = rulesGravityFramesForDifficulty(env->difficulty[i]);
+
+        env->softDropInitiated[i] = false;
+        env->softDropStartingRow[i] = 0;
+        env->hardDropInitiated[i] = false;
+        env->hardDropStartingRow[i] = 0;
+
+        changeStatus(env, i, ARE);
+    }
+}
+
+// Piece drops from gravity and is moved by the player
+// Follows updateSceneDropping in the board scene step for step
+static void stepDropping(Env* env, int i, const Bitboard board, uint8_t current, uint8_t pushed) {
+    bool enforceGravity = false;
+    Piece piece = env->piece[i];
+
+    // If DOWN is newly pressed, force soft drop gravity
+    // Ignore if any other direction button is pressed too
+    if ((pushed & 0xF) == ENV_BUTTON_DOWN) {
+        env->gravityFrames[i] = SOFTDROP_GRAVITY;
+
+        if (!env->softDropInitiated[i]) {
+            env->softDropInitiated[i] = true;
+            env->softDropStartingRow[i] = env->pieceRow[i];
+        }
+    }
+
+    // Enforce gravity when counter expires and reset it
+    if (--env->gravityFrames[i] == 0) {
+        enforceGravity = true;
+
+        if (env->softDropInitiated[i] && ((current & 0xF) == ENV_BUTTON_DOWN)) {
+            env->gravityFrames[i] = SOFTDROP_GRAVITY;
+        } else {
+            env->gravityFrames[i] = rulesGravityFramesForDifficulty(env->difficulty[i]);
+            env->softDropInitiated[i] = false;
+        }
+    }
+
+    int dasRepeatKey = dasRepeatCheck(env, i);
+
+    if (!(enforceGravity || (pushed > 0) || (dasRepeatKey > 0))) {
+        return;
+    }
+
+    Position currentPos = piecePosition(env, i);
+    Position attemptedPos = currentPos;
+    Position finalPos = attemptedPos;
+    bool shouldSettle = false;
+
+    if ((pushed & ENV_BUTTON_UP) == ENV_BUTTON_UP) {
+        finalPos = bitboardDropPosition(board, piece, finalPos);
+        shouldSettle = true;
+
+        env->hardDropInitiated[i] = true;
+        env->hardDropStartingRow[i] = env->pieceRow[i];
+    } else {
+        if ((dasRepeatKey | (pushed & ENV_BUTTON_RIGHT)) == ENV_BUTTON_RIGHT) {
+            attemptedPos.col++;
+        } else if ((dasRepeatKey | (pushed & ENV_BUTTON_LEFT)) == ENV_BUTTON_LEFT) {
+            attemptedPos.col--;
+        }
+
+        if (enforceGravity || ((pushed & ENV_BUTTON_DOWN) == ENV_BUTTON_DOWN)) {
+            attemptedPos.row++;
+        }
+
+        if ((pushed & ENV_BUTTON_A) == ENV_BUTTON_A) {
+            if (++attemptedPos.orientation > 3) {
+                attemptedPos.orientation = 0;
+            }
+        }
+
+        if ((pushed & ENV_BUTTON_B) == ENV_BUTTON_B) {
+            if (--attemptedPos.orientation < 0) {
+                attemptedPos.orientation = 3;
+            }
+        }
+
+        if (attemptedPos.row > currentPos.row && bitboardCanSettle(board, piece, currentPos)) {
+            shouldSettle = true;
+        } else if (bitboardPieceFits(board, piece, attemptedPos)) {
+            finalPos = attemptedPos;
+        } else if (enforceGravity) {
+            finalPos.row++;
+        }
+    }
+
+    env->pieceRow[i] = finalPos.row;
+    env->pieceCol[i] = finalPos.col;
+    env->pieceOrientation[i] = finalPos.orientation;
+
+    if (shouldSettle) {
+        changeStatus(env, i, Settled);
+    }
+}
+
+// Locks the piece, checks for completed lines and scores drops
+static void stepSettled(Env* env, int i, Bitboard board) {
+    bitboardAddPiece(board, env->piece[i], piecePosition(env, i));
+    env->pieces[i]++;
+
+    env->completedRows[i] = bitboardCompletedRows(board);
+
+    if (env->softDropInitiated[i]) {
+        env->score[i] = rulesIncrementScore(env->score[i], env->pieceRow[i] - env->softDropStartingRow[i]);
+    }
+
+    if (env->hardDropInitiated[i]) {
+        env->score[i] = rulesIncrementScore(env->score[i], (env->pieceRow[i] - env->hardDropStartingRow[i]) * 2);
+    }
+
+    changeStatus(env, i, env->completedRows[i] != 0 ? LineClear : Start);
+}
+
+// Waits out the line clear animation, then removes and scores the completed rows
+static void stepLineClear(Env* env, int i, Bitboard board) {
+    if (env->statusFrames[i]++ == LINECLEAR_FRAMES) {
+        int numRows = __builtin_popcount(env->completedRows[i]);
+
+        bitboardRemoveRows(board, env->completedRows[i]);
+
+        env->score[i] = rulesIncrementScore(env->score[i], rulesScoreForLines(numRows, env->difficulty[i]));
+        env->completedLines[i] += numRows;
+        env->completedRows[i] = 0;
+
+        changeStatus(env, i, Start);
+    }
+}
+
+// Step boards [first, last) one frame. Runs on the calling thread only
+void envStepRange(Env* env, int first, int last, const uint8_t* current, const uint8_t* pushed) {
+    for (int i = first; i < last; i++) {
+        if (envIsFinished(env, i)) {
+            continue;
+        }
+
+        BitboardRow* board = &env->rows[i * BITBOARD_STRIDE];
+
+        updateDasCounts(env, i, current[i]);
+
+        switch ((Status)env->status[i]) {
+            case Start:
+                stepStart(env, i, board);
+                break;
+
+            case ARE:
+                if (++env->statusFrames[i] == ARE_FRAMES) {
+                    changeStatus(env, i, Dropping);
+                }
+                break;
+
+            case Dropping:
+                stepDropping(env, i, board, current[i], pushed[i]);
+                break;
+
+            case Settled:
+                stepSettled(env, i, board);
+                break;
+
+            case LineClear:
+                stepLineClear(env, i, board);
+                break;
+
+            case TopOut:
+            case GameOver:
+                break;
+        }
+
+        env->frames[i]++;
+    }
+}
+
+// Step every board one frame
+void envStep(Env* env, const uint8_t* current, const uint8_t* pushed) {
+    EnvPool* pool = env->pool;
+
+    if (pool == NULL) {
+        envStepRange(env, 0, env->numBoards, current, pushed);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->current = current;
+    pool->pushed = pushed;
+    pool->pending = pool->numThreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->startCond);
+    pthread_mutex_unlock(&pool->lock);
+
+    // The calling thread takes the first shard
+    int first;
+    int last;
+    shardRange(env, pool->numThreads + 1, 0, &first, &last);
+    envStepRange(env, first, last, current, pushed);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->doneCond, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Destroy and deallocate a batch
+void envDestroy(Env* env) {
+    if (env->pool != NULL) {
+        destroyPool(env->pool);
+    }
+
+    free(env->rows);
+    free(env->rng);
+    free(env->status);
+    free(env->statusFrames);
+    free(env->piece);
+    free(env->standbyPiece);
+    free(env->pieceRow);
+    free(env->pieceCol);
+    free(env->pieceOrientation);
+    free(env->gravityFrames);
+    free(env->dasKey);
+    free(env->dasCharged);
+    free(env->dasFrames);
+    free(env->softDropInitiated);
+    free(env->softDropStartingRow);
+    free(env->hardDropInitiated);
+    free(env->hardDropStartingRow);
+    free(env->completedRows);
+    free(env->initialDifficulty);
+    free(env->difficulty);
+    free(env->completedLines);
+    free(env->score);
+    free(env->frames);
+    free(env->pieces);
+    free(env);
+}
\ No newline at end of file
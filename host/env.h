@@ -0,0 +1,136 @@
+#ifndef HOST_ENV_H
+#define HOST_ENV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "scenes/board/bitboard.h"
+#include "scenes/board/rules.h"
+
+// Batched board simulation for the host.
+// Steps any number of independent games one frame at a time with the same rules as the board scene.
+// State is kept as one array per field (indexed by board) so callers can read it without copying.
+
+// Button bits, same values as the Playdate SDK's PDButtons
+#define ENV_BUTTON_LEFT 1
+#define ENV_BUTTON_RIGHT 2
+#define ENV_BUTTON_UP 4
+#define ENV_BUTTON_DOWN 8
+#define ENV_BUTTON_B 16
+#define ENV_BUTTON_A 32
+
+// Boards handed to each worker thread are rounded to this many so threads never share cache lines
+#define ENV_SHARD_ALIGNMENT 64
+
+typedef struct EnvPool EnvPool;
+
+typedef struct Env {
+    int numBoards;
+
+    // Locked cells of each board, BITBOARD_STRIDE rows per board
+    BitboardRow* rows;
+
+    // RNG state used by the piece picker
+    uint32_t* rng;
+
+    // Status and number of frames spent in it
+    uint8_t* status;
+    uint32_t* statusFrames;
+
+    // Current player piece, its position and the next piece in line
+    int8_t* piece;
+    int8_t* standbyPiece;
+    int8_t* pieceRow;
+    int8_t* pieceCol;
+    int8_t* pieceOrientation;
+
+    uint16_t* gravityFrames;
+
+    // DAS key being held, whether it's charged and its frame count
+    uint8_t* dasKey;
+    uint8_t* dasCharged;
+    int32_t* dasFrames;
+
+    // Soft & hard drop tracking used for scoring
+    uint8_t* softDropInitiated;
+    int8_t* softDropStartingRow;
+    uint8_t* hardDropInitiated;
+    int8_t* hardDropStartingRow;
+
+    // Rows being cleared during LineClear (bit N is row N)
+    uint32_t* completedRows;
+
+    int16_t* initialDifficulty;
+    int16_t* difficulty;
+    int32_t* completedLines;
+    int32_t* score;
+
+    // Frames stepped and pieces locked since the board was reset
+    uint32_t* frames;
+    uint32_t* pieces;
+
+    EnvPool* pool;
+} Env;
+
+// Copy of a single board's state, used to rewind a board
+typedef struct EnvSnapshot {
+    BitboardRow rows[BITBOARD_STRIDE];
+
+    uint32_t rng;
+    uint32_t statusFrames;
+    uint32_t completedRows;
+    uint32_t frames;
+    uint32_t pieces;
+    int32_t dasFrames;
+    int32_t completedLines;
+    int32_t score;
+
+    uint16_t gravityFrames;
+    int16_t initialDifficulty;
+    int16_t difficulty;
+
+    uint8_t status;
+    uint8_t dasKey;
+    uint8_t dasCharged;
+    uint8_t softDropInitiated;
+    uint8_t hardDropInitiated;
+
+    int8_t piece;
+    int8_t standbyPiece;
+    int8_t pieceRow;
+    int8_t pieceCol;
+    int8_t pieceOrientation;
+    int8_t softDropStartingRow;
+    int8_t hardDropStartingRow;
+} EnvSnapshot;
+
+// Create a batch of boards. Boards are stepped on numThreads threads (including the caller)
+// All boards start reset with seed 0 at difficulty 0
+// Returns NULL if the boards couldn't be allocated or the threads couldn't be started
+Env* envCreate(int numBoards, int numThreads);
+
+// Start a new game on a board
+void envReset(Env* env, int board, unsigned int seed, int initialDifficulty);
+
+// Step every board one frame
+// current holds the buttons held on this frame and pushed the buttons pressed since the last frame, one entry per board
+// Boards that have topped out are left as they are
+void envStep(Env* env, const uint8_t* current, const uint8_t* pushed);
+
+// Step boards [first, last) one frame. Runs on the calling thread only
+void envStepRange(Env* env, int first, int last, const uint8_t* current, const uint8_t* pushed);
+
+// Copy a board's state into a snapshot
+void envSnapshot(const Env* env, int board, EnvSnapshot* snapshot);
+
+// Put a board back to the state held in a snapshot
+void envRestore(Env* env, int board, const EnvSnapshot* snapshot);
+
+// Returns whether a board's game has ended
+static inline bool envIsFinished(const Env* env, int board) {
+    return env->status[board] >= TopOut;
+}
+
+// Destroy and deallocate a batch
+void envDestroy(Env* env);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "scenes/board/bitboard.h"
+#include "scenes/board/rules.h"
+
+// Generates the finesse table: the fewest inputs needed to move each piece from where it spawns
+// to every orientation and column, on an empty playfield.
+//
+//   pwb-finesse [output]
+//
+// Writes src/scenes/board/finesseTable.h to the output path, or to stdout if none is given.
+// Shapes come from matrix.c through the bitboard, so the table must be regenerated if they change.
+
+// Columns a piece position can be at, from -2 (I piece flat against the left wall) up to the last column
+#define COL_OFFSET 2
+#define NUM_COLS (MATRIX_GRID_COLS + COL_OFFSET)
+
+#define UNREACHABLE 0xFF
+
+// Fewest inputs to reach each orientation and column
+static uint8_t inputs[7][4][NUM_COLS];
+
+// Row the inputs are made at. The first row every orientation of every piece fits in at the spawn column,
+// since a rotation that doesn't fit at the top has to wait for gravity
+static int moveRow(const Bitboard board) {
+    for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
+        bool allFit = true;
+
+        for (int piece = O; piece <= J; piece++) {
+            for (int orientation = 0; orientation < 4; orientation++) {
+                Position pos = { .row = row, .col = SPAWN_COL, .orientation = orientation };
+
+                if (!bitboardPieceFits(board, (Piece)piece, pos)) {
+                    allFit = false;
+                }
+            }
+        }
+
+        if (allFit) {
+            return row;
+        }
+    }
+
+    return 0;
+}
+
+// Breadth first search over the single inputs the board scene responds to: a tap left or right, a rotation either way,
+// or holding left or right so DAS moves the piece to the wall
+static void searchPiece(const Bitboard board, Piece piece, int row) {
+    int queue[4 * NUM_COLS][2];
+    int head = 0;
+    int tail = 0;
+
+    memset(inputs[piece], UNREACHABLE, sizeof(inputs[piece]));
+
+    inputs[piece][SPAWN_ORIENTATION][SPAWN_COL + COL_OFFSET] = 0;
+    queue[tail][0] = SPAWN_ORIENTATION;
+    queue[tail][1] = SPAWN_COL;
+    tail++;
+
+    while (head < tail) {
+        int orientation = queue[head][0];
+        int col = queue[head][1];
+        head++;
+
+        Position moves[6];
+        int numMoves = 0;
+
+        moves[numMoves++] = (Position){ .row = row, .col = col - 1, .orientation = orientation };
+        moves[numMoves++] = (Position){ .row = row, .col = col + 1, .orientation = orientation };
+        moves[numMoves++] = (Position){ .row = row, .col = col, .orientation = (orientation + 1) % 4 };
+        moves[numMoves++] = (Position){ .row = row, .col = col, .orientation = (orientation + 3) % 4 };
+
+        for (int direction = -1; direction <= 1; direction += 2) {
+            Position wall = { .row = row, .col = col, .orientation = orientation };
+
+            while (bitboardPieceFits(board, piece, (Position){ .row = row, .col = wall.col + direction, .orientation = orientation })) {
+                wall.col += direction;
+            }
+
+            moves[numMoves++] = wall;
+        }
+
+        for (int i = 0; i < numMoves; i++) {
+            Position pos = moves[i];
+
+            if (pos.col < -COL_OFFSET || pos.col >= MATRIX_GRID_COLS || !bitboardPieceFits(board, piece, pos)) {
+                continue;
+            }
+
+            if (inputs[piece][pos.orientation][pos.col + COL_OFFSET] == UNREACHABLE) {
+                inputs[piece][pos.orientation][pos.col + COL_OFFSET] = (uint8_t)(inputs[piece][orientation][col + COL_OFFSET] + 1);
+                queue[tail][0] = pos.orientation;
+                queue[tail][1] = pos.col;
+                tail++;
+            }
+        }
+    }
+}
+
+// Cells a piece fills once dropped onto the floor, as a mask of the bottom 4 rows
+static uint64_t landingCells(const Bitboard board, Piece piece, Position pos) {
+    Position landed = bitboardDropPosition(board, piece, pos);
+    MatrixPiecePoints points = matrixGetPointsForPiece(piece, landed.col, landed.row, landed.orientation);
+    uint64_t cells = 0;
+
+    for (int i = 0; i < points.numPoints; i++) {
+        cells |= 1ULL << (((points.points[i][1] - (MATRIX_GRID_ROWS - 4)) * MATRIX_GRID_COLS) + points.points[i][0]);
+    }
+
+    return cells;
+}
+
+// Orientations that look the same (all 4 of the O, or both flat S orientations) land on the same cells.
+// A placement only needs as many inputs as the cheapest way to land on its cells
+static void mergeSameLandings(const Bitboard board, Piece piece, int row) {
+    uint8_t merged[4][NUM_COLS];
+
+    memcpy(merged, inputs[piece], sizeof(merged));
+
+    for (int orientation = 0; orientation < 4; orientation++) {
+        for (int col = -COL_OFFSET; col < MATRIX_GRID_COLS; col++) {
+            if (inputs[piece][orientation][col + COL_OFFSET] == UNREACHABLE) {
+                continue;
+            }
+
+            uint64_t cells = landingCells(board, piece, (Position){ .row = row, .col = col, .orientation = orientation });
+
+            for (int other = 0; other < 4; other++) {
+                for (int otherCol = -COL_OFFSET; otherCol < MATRIX_GRID_COLS; otherCol++) {
+                    uint8_t otherInputs = inputs[piece][other][otherCol + COL_OFFSET];
+
+                    if (otherInputs < merged[orientation][col + COL_OFFSET]
+                        && landingCells(board, piece, (Position){ .row = row, .col = otherCol, .orientation = other }) == cells) {
+                        merged[orientation][col + COL_OFFSET] = otherInputs;
+                    }
+                }
+            }
+        }
+    }
+
+    memcpy(inputs[piece], merged, sizeof(merged));
+}
+
+static void writeTable(FILE* out) {
+    static const char* PIECE_NAMES[7] = { "O", "I", "S", "Z", "T", "L", "J" };
+
+    fprintf(out,
+        "#ifndef SCENES_BOARD_FINESSETABLE_H\n"
+        "#define SCENES_BOARD_FINESSETABLE_H\n"
+        "\n"
+        "#include <stdint.h>\n"
+        "\n"
+        "// Generated by pwb-finesse from the piece shapes in matrix.c. Regenerate rather than editing by hand\n"
+        "//\n"
+        "// Fewest inputs needed to move a piece from where it spawns to each orientation and column on an empty playfield.\n"
+        "// Taps, rotations and holding left or right into the wall each count as one input\n"
+        "\n"
+        "// Added to a piece position's column to index the table, as positions can be left of the playfield\n"
+        "#define FINESSE_COL_OFFSET %d\n"
+        "#define FINESSE_COLS %d\n"
+        "\n"
+        "// The piece can't be at this orientation and column\n"
+        "#define FINESSE_UNREACHABLE 0x%02X\n"
+        "\n"
+        "static const uint8_t FINESSE_INPUTS[7][4][FINESSE_COLS] = {\n",
+        COL_OFFSET, NUM_COLS, UNREACHABLE);
+
+    for (int piece = O; piece <= J; piece++) {
+        fprintf(out, "    // %s\n    {\n", PIECE_NAMES[piece]);
+
+        for (int orientation = 0; orientation < 4; orientation++) {
+            fprintf(out, "        {");
+
+            for (int col = 0; col < NUM_COLS; col++) {
+                if (inputs[piece][orientation][col] == UNREACHABLE) {
+                    fprintf(out, "%s0x%02X", col > 0 ? ", " : " ", UNREACHABLE);
+                } else {
+                    fprintf(out, "%s%4u", col > 0 ? ", " : " ", inputs[piece][orientation][col]);
+                }
+            }
+
+            fprintf(out, " }%s\n", orientation < 3 ? "," : "");
+        }
+
+        fprintf(out, "    }%s\n", piece < J ? "," : "");
+    }
+
+    fprintf(out,
+        "};\n"
+        "\n"
+        "#endif");
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [output]\n", argv[0]);
+        return 1;
+    }
+
+    Bitboard board;
+
+    bitboardInit();
+    bitboardClear(board);
+
+    int row = moveRow(board);
+
+    for (int piece = O; piece <= J; piece++) {
+        searchPiece(board, (Piece)piece, row);
+        mergeSameLandings(board, (Piece)piece, row);
+    }
+
+    FILE* out = argc == 2 ? fopen(argv[1], "w") : stdout;
+
+    if (out == NULL) {
+        fprintf(stderr, "Unable to write '%s'\n", argv[1]);
+        return 1;
+    }
+
+    writeTable(out);
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "replayIndex.h"
+
+// Builds and searches an index of the results of recorded games
+//
+//   pwb-index [-i index] update directory
+//   pwb-index [-i index] query [-c] [column=min..max ...]
+
+#define DEFAULT_INDEX_PATH "replays.pwbx"
+
+// Names used for columns on the command line and in query output
+static const char* COLUMN_NAMES[ReplayIndexColumnCount] = {
+    [ReplayIndexSeed] = "seed",
+    [ReplayIndexInitialDifficulty] = "start",
+    [ReplayIndexScore] = "score",
+    [ReplayIndexCompletedLines] = "lines",
+    [ReplayIndexDifficulty] = "level",
+    [ReplayIndexFrames] = "frames",
+    [ReplayIndexPieces] = "pieces",
+    [ReplayIndexFlags] = "flags"
+};
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "Usage: %s [-i index] update directory\n"
+        "       %s [-i index] query [-c] [column=min..max ...]\n"
+        "  -i index      Index file (default " DEFAULT_INDEX_PATH ")\n"
+        "  -c            Only count matching games\n"
+        "Columns are seed, start, score, lines, level, frames, pieces and flags.\n"
+        "Ranges are inclusive and either end can be left out, e.g. start=15.. lines=201.. seed=0x1A2B3C4D\n"
+        "Games played with rule variations such as versus or cascade have non-zero flags. Use flags=0 for standard games\n",
+        name, name);
+}
+
+static double secondsSince(const struct timespec* started) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)(now.tv_sec - started->tv_sec) + ((double)(now.tv_nsec - started->tv_nsec) / 1e9);
+}
+
+// Parse a "column=min..max" term into a filter
+static bool parseTerm(ReplayIndexFilter* filter, const char* term) {
+    const char* equals = strchr(term, '=');
+
+    if (equals == NULL) {
+        return false;
+    }
+
+    int column = -1;
+
+    for (int i = 0; i < ReplayIndexColumnCount; i++) {
+        if (strlen(COLUMN_NAMES[i]) == (size_t)(equals - term) && strncmp(term, COLUMN_NAMES[i], (size_t)(equals - term)) == 0) {
+            column = i;
+        }
+    }
+
+    if (column < 0) {
+        return false;
+    }
+
+    const char* value = equals + 1;
+    const char* dots = strstr(value, "..");
+    char* end;
+
+    uint32_t min = 0;
+    uint32_t max = UINT32_MAX;
+
+    if (dots == NULL) {
+        min = max = (uint32_t)strtoul(value, &end, 0);
+
+        if (end == value || *end != '\0') {
+            return false;
+        }
+    } else {
+        if (dots != value) {
+            min = (uint32_t)strtoul(value, &end, 0);
+
+            if (end != dots) {
+                return false;
+            }
+        }
+
+        if (dots[2] != '\0') {
+            max = (uint32_t)strtoul(dots + 2, &end, 0);
+
+            if (*end != '\0') {
+                return false;
+            }
+        }
+    }
+
+    replayIndexFilterSet(filter, (ReplayIndexColumn)column, min, max);
+
+    return true;
+}
+
+static void printMatch(const ReplayIndex* index, uint64_t game, void* userdata) {
+    (void)userdata;
+
+    printf("%-32s %08X %5u %7u %5u %5u %8u %6u %5X\n",
+        replayIndexName(index, game),
+        replayIndexValue(index, game, ReplayIndexSeed),
+        replayIndexValue(index, game, ReplayIndexInitialDifficulty),
+        replayIndexValue(index, game, ReplayIndexScore),
+        replayIndexValue(index, game, ReplayIndexCompletedLines),
+        replayIndexValue(index, game, ReplayIndexDifficulty),
+        replayIndexValue(index, game, ReplayIndexFrames),
+        replayIndexValue(index, game, ReplayIndexPieces),
+        replayIndexValue(index, game, ReplayIndexFlags));
+}
+
+static int runUpdate(const char* indexPath, const char* directory) {
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    long added = replayIndexUpdate(indexPath, directory);
+
+    if (added < 0) {
+        fprintf(stderr, "Unable to update '%s' from '%s'\n", indexPath, directory);
+        return 1;
+    }
+
+    printf("Added %ld games in %.3fs\n", added, secondsSince(&started));
+
+    return 0;
+}
+
+static int runQuery(const char* indexPath, const ReplayIndexFilter* filter, bool countOnly) {
+    ReplayIndex* index = replayIndexOpen(indexPath);
+
+    if (index == NULL) {
+        fprintf(stderr, "Unable to open '%s'\n", indexPath);
+        return 1;
+    }
+
+    if (!countOnly) {
+        printf("%-32s %-8s %5s %7s %5s %5s %8s %6s %5s\n", "name", COLUMN_NAMES[0], COLUMN_NAMES[1], COLUMN_NAMES[2], COLUMN_NAMES[3], COLUMN_NAMES[4], COLUMN_NAMES[5], COLUMN_NAMES[6], COLUMN_NAMES[7]);
+    }
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    uint64_t matches = replayIndexQuery(index, filter, countOnly ? NULL : printMatch, NULL);
+
+    printf("%" PRIu64 " of %" PRIu64 " games matched in %.3fms\n", matches, index->numGames, secondsSince(&started) * 1000);
+
+    replayIndexClose(index);
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* indexPath = DEFAULT_INDEX_PATH;
+    bool countOnly = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+i:")) != -1) {
+        switch (opt) {
+            case 'i':
+                indexPath = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* command = argv[optind++];
+
+    if (strcmp(command, "update") == 0 && optind == argc - 1) {
+        return runUpdate(indexPath, argv[optind]);
+    } else if (strcmp(command, "query") == 0) {
+        ReplayIndexFilter filter;
+        replayIndexFilterInit(&filter);
+
+        for (; optind < argc; optind++) {
+            if (strcmp(argv[optind], "-c") == 0) {
+                countOnly = true;
+            } else if (!parseTerm(&filter, argv[optind])) {
+                fprintf(stderr, "Invalid filter '%s'\n", argv[optind]);
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        return runQuery(indexPath, &filter, countOnly);
+    }
+
+    usage(argv[0]);
+
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,381 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "replayIndex.h"
+#include "scenes/board/replayFormat.h"
+
+_Static_assert(sizeof(ReplayIndexHeader) == 64, "Replay index header must keep blocks aligned");
+_Static_assert(sizeof(ReplayIndexBlock) % 64 == 0, "Replay index blocks must keep columns aligned");
+
+// A replay found in the archive directory
+typedef struct ReplayIndexCandidate {
+    char name[REPLAY_INDEX_NAME_LENGTH];
+    uint64_t size;
+} ReplayIndexCandidate;
+
+// Open addressed set of the names already in an index
+typedef struct ReplayIndexNameSet {
+    const ReplayIndexBlock* blocks;
+    uint64_t* slots;
+    uint64_t mask;
+} ReplayIndexNameSet;
+
+static size_t mapSizeForGames(uint64_t numGames) {
+    uint64_t numBlocks = (numGames + REPLAY_INDEX_BLOCK_GAMES - 1) / REPLAY_INDEX_BLOCK_GAMES;
+
+    return sizeof(ReplayIndexHeader) + ((size_t)numBlocks * sizeof(ReplayIndexBlock));
+}
+
+static const char* blockName(const ReplayIndexBlock* blocks, uint64_t game) {
+    return blocks[game / REPLAY_INDEX_BLOCK_GAMES].name[game % REPLAY_INDEX_BLOCK_GAMES];
+}
+
+static uint64_t hashName(const char* name) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    while (*name != '\0') {
+        hash = (hash ^ (uint8_t)*name++) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// Slots hold game + 1 so zero marks an empty slot
+static void nameSetAdd(ReplayIndexNameSet* set, uint64_t game) {
+    uint64_t slot = hashName(blockName(set->blocks, game)) & set->mask;
+
+    while (set->slots[slot] != 0) {
+        slot = (slot + 1) & set->mask;
+    }
+
+    set->slots[slot] = game + 1;
+}
+
+static bool nameSetContains(const ReplayIndexNameSet* set, const char* name) {
+    uint64_t slot = hashName(name) & set->mask;
+
+    while (set->slots[slot] != 0) {
+        if (strcmp(blockName(set->blocks, set->slots[slot] - 1), name) == 0) {
+            return true;
+        }
+
+        slot = (slot + 1) & set->mask;
+    }
+
+    return false;
+}
+
+// Collect every replay in a directory with a name short enough to be indexed
+// Returns NULL if the directory can't be read or there's not enough memory
+static ReplayIndexCandidate* findCandidates(const char* directory, uint64_t* numCandidates) {
+    DIR* dir = opendir(directory);
+
+    if (dir == NULL) {
+        return NULL;
+    }
+
+    ReplayIndexCandidate* candidates = NULL;
+    uint64_t count = 0;
+    uint64_t capacity = 0;
+    size_t extensionLength = strlen(REPLAY_EXTENSION);
+    int dirFd = dirfd(dir);
+    struct dirent* entry;
+
+    while ((entry = readdir(dir)) != NULL) {
+        size_t length = strlen(entry->d_name);
+
+        if (length <= extensionLength || length >= REPLAY_INDEX_NAME_LENGTH || strcmp(entry->d_name + length - extensionLength, REPLAY_EXTENSION) != 0) {
+            continue;
+        }
+
+        struct stat info;
+
+        if (fstatat(dirFd, entry->d_name, &info, 0) != 0 || !S_ISREG(info.st_mode)) {
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 1024;
+            ReplayIndexCandidate* grown = realloc(candidates, capacity * sizeof(ReplayIndexCandidate));
+
+            if (grown == NULL) {
+                closedir(dir);
+                free(candidates);
+                return NULL;
+            }
+
+            candidates = grown;
+        }
+
+        memcpy(candidates[count].name, entry->d_name, length + 1);
+        candidates[count].size = (uint64_t)info.st_size;
+        count++;
+    }
+
+    closedir(dir);
+
+    *numCandidates = count;
+
+    // An empty directory still succeeds
+    return candidates != NULL ? candidates : calloc(1, sizeof(ReplayIndexCandidate));
+}
+
+// Read the header of a finished replay. Returns false for games still being recorded or other files
+static bool readReplayHeader(int dirFd, const ReplayIndexCandidate* candidate, ReplayHeader* header) {
+    int fd = openat(dirFd, candidate->name, O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = pread(fd, header, sizeof(ReplayHeader), 0) == sizeof(ReplayHeader);
+    close(fd);
+
+    return ok
+        && header->magic == REPLAY_MAGIC
+        && header->version == REPLAY_VERSION
+        && candidate->size == sizeof(ReplayHeader) + ((uint64_t)header->numFrames * sizeof(ReplayFrame));
+}
+
+// Add every replay in a directory that isn't already in the index. The index is created if it doesn't exist
+// Returns the number of games added, or -1 if the index couldn't be written
+long replayIndexUpdate(const char* indexPath, const char* directory) {
+    uint64_t numCandidates = 0;
+    ReplayIndexCandidate* candidates = findCandidates(directory, &numCandidates);
+
+    if (candidates == NULL) {
+        return -1;
+    }
+
+    int fd = open(indexPath, O_RDWR | O_CREAT, 0644);
+    int dirFd = open(directory, O_RDONLY | O_DIRECTORY);
+
+    if (fd < 0 || dirFd < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        free(candidates);
+        return -1;
+    }
+
+    ReplayIndexHeader header = {
+        .magic = REPLAY_INDEX_MAGIC,
+        .version = REPLAY_INDEX_VERSION,
+        .blockGames = REPLAY_INDEX_BLOCK_GAMES,
+        .blockSize = sizeof(ReplayIndexBlock),
+        .numGames = 0
+    };
+
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0;
+
+    // Only add to indexes with a matching layout
+    if (ok && info.st_size > 0) {
+        ok = pread(fd, &header, sizeof(header), 0) == sizeof(header)
+            && header.magic == REPLAY_INDEX_MAGIC
+            && header.version == REPLAY_INDEX_VERSION
+            && header.blockGames == REPLAY_INDEX_BLOCK_GAMES
+            && header.blockSize == sizeof(ReplayIndexBlock)
+            && (size_t)info.st_size >= mapSizeForGames(header.numGames);
+    }
+
+    // The name set is allocated before the index is grown so running out of memory leaves it untouched
+    ReplayIndexNameSet names = { 0 };
+    uint64_t numSlots = 16;
+
+    while (numSlots < (header.numGames + numCandidates) * 2) {
+        numSlots *= 2;
+    }
+
+    if (ok) {
+        names.slots = calloc(numSlots, sizeof(uint64_t));
+        names.mask = numSlots - 1;
+        ok = names.slots != NULL;
+    }
+
+    // Make room for every candidate. Space for replays that are already indexed is trimmed afterwards
+    size_t mapSize = mapSizeForGames(header.numGames + numCandidates);
+    void* map = MAP_FAILED;
+
+    if (ok && ftruncate(fd, (off_t)mapSize) == 0) {
+        map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    if (map == MAP_FAILED) {
+        close(fd);
+        close(dirFd);
+        free(names.slots);
+        free(candidates);
+        return -1;
+    }
+
+    ReplayIndexBlock* blocks = (ReplayIndexBlock*)((uint8_t*)map + sizeof(ReplayIndexHeader));
+    names.blocks = blocks;
+
+    for (uint64_t game = 0; game < header.numGames; game++) {
+        nameSetAdd(&names, game);
+    }
+
+    uint64_t numGames = header.numGames;
+
+    for (uint64_t i = 0; i < numCandidates; i++) {
+        ReplayIndexCandidate* candidate = &candidates[i];
+        ReplayHeader replay;
+
+        if (nameSetContains(&names, candidate->name) || !readReplayHeader(dirFd, candidate, &replay)) {
+            continue;
+        }
+
+        ReplayIndexBlock* block = &blocks[numGames / REPLAY_INDEX_BLOCK_GAMES];
+        uint64_t slot = numGames % REPLAY_INDEX_BLOCK_GAMES;
+
+        block->columns[ReplayIndexSeed][slot] = replay.seed;
+        block->columns[ReplayIndexInitialDifficulty][slot] = replay.initialDifficulty;
+        block->columns[ReplayIndexScore][slot] = replay.score;
+        block->columns[ReplayIndexCompletedLines][slot] = replay.completedLines;
+        block->columns[ReplayIndexDifficulty][slot] = replay.difficulty;
+        block->columns[ReplayIndexFrames][slot] = replay.numFrames;
+        block->columns[ReplayIndexPieces][slot] = replay.pieces;
+        block->columns[ReplayIndexFlags][slot] = replay.flags;
+        memcpy(block->name[slot], candidate->name, REPLAY_INDEX_NAME_LENGTH);
+
+        nameSetAdd(&names, numGames);
+        numGames++;
+    }
+
+    long added = (long)(numGames - header.numGames);
+
+    // The count is written last so an interrupted update leaves the index as it was
+    header.numGames = numGames;
+    memcpy(map, &header, sizeof(header));
+
+    ok = msync(map, mapSize, MS_SYNC) == 0;
+    munmap(map, mapSize);
+
+    ok = ftruncate(fd, (off_t)mapSizeForGames(numGames)) == 0 && ok;
+    ok = close(fd) == 0 && ok;
+
+    close(dirFd);
+    free(names.slots);
+    free(candidates);
+
+    return ok ? added : -1;
+}
+
+// Map an index for reading
+ReplayIndex* replayIndexOpen(const char* path) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ReplayIndexHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const ReplayIndexHeader* header = map;
+
+    if (header->magic != REPLAY_INDEX_MAGIC
+        || header->version != REPLAY_INDEX_VERSION
+        || header->blockGames != REPLAY_INDEX_BLOCK_GAMES
+        || header->blockSize != sizeof(ReplayIndexBlock)
+        || (size_t)info.st_size < mapSizeForGames(header->numGames)) {
+        munmap(map, (size_t)info.st_size);
+        return NULL;
+    }
+
+    ReplayIndex* index = calloc(1, sizeof(ReplayIndex));
+
+    if (index == NULL) {
+        munmap(map, (size_t)info.st_size);
+        return NULL;
+    }
+
+    index->map = map;
+    index->mapSize = (size_t)info.st_size;
+    index->blocks = (const ReplayIndexBlock*)((const uint8_t*)map + sizeof(ReplayIndexHeader));
+    index->numGames = header->numGames;
+
+    return index;
+}
+
+// Unmap and deallocate an index
+void replayIndexClose(ReplayIndex* index) {
+    munmap(index->map, index->mapSize);
+    free(index);
+}
+
+// Set a filter to match every game
+void replayIndexFilterInit(ReplayIndexFilter* filter) {
+    for (int column = 0; column < ReplayIndexColumnCount; column++) {
+        filter->min[column] = 0;
+        filter->max[column] = UINT32_MAX;
+    }
+}
+
+// Limit a column of a filter to [min, max]
+void replayIndexFilterSet(ReplayIndexFilter* filter, ReplayIndexColumn column, uint32_t min, uint32_t max) {
+    filter->min[column] = min;
+    filter->max[column] = max;
+}
+
+// Find every game matching a filter. The callback may be NULL to only count them
+// Returns the number of matching games
+uint64_t replayIndexQuery(const ReplayIndex* index, const ReplayIndexFilter* filter, ReplayIndexMatchCallback callback, void* userdata) {
+    uint64_t matches = 0;
+    uint8_t matched[REPLAY_INDEX_BLOCK_GAMES];
+
+    for (uint64_t first = 0; first < index->numGames; first += REPLAY_INDEX_BLOCK_GAMES) {
+        const ReplayIndexBlock* block = &index->blocks[first / REPLAY_INDEX_BLOCK_GAMES];
+        int count = (index->numGames - first) < REPLAY_INDEX_BLOCK_GAMES ? (int)(index->numGames - first) : REPLAY_INDEX_BLOCK_GAMES;
+
+        memset(matched, 1, sizeof(matched));
+
+        // Test a whole column at a time. A range check is a single unsigned compare once offset by min
+        for (int column = 0; column < ReplayIndexColumnCount; column++) {
+            uint32_t min = filter->min[column];
+            uint32_t range = filter->max[column] - min;
+
+            if (min == 0 && range == UINT32_MAX) {
+                continue;
+            } else if (filter->max[column] < min) {
+                memset(matched, 0, sizeof(matched));
+                break;
+            }
+
+            const uint32_t* values = block->columns[column];
+
+            for (int i = 0; i < REPLAY_INDEX_BLOCK_GAMES; i++) {
+                matched[i] &= (uint8_t)((values[i] - min) <= range);
+            }
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (matched[i]) {
+                matches++;
+
+                if (callback != NULL) {
+                    callback(index, first + (uint64_t)i, userdata);
+                }
+            }
+        }
+    }
+
+    return matches;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef HOST_REPLAYINDEX_H
+#define HOST_REPLAYINDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Index of the results of every replay in an archive, so games can be searched without opening them.
+// Games are stored in blocks of REPLAY_INDEX_BLOCK_GAMES with each block holding one array per column,
+// so a filter only reads the columns it tests. New games fill the last block and then add new ones,
+// so existing entries are never moved. Finished replays are never rewritten, so games are indexed once by name.
+
+#define REPLAY_INDEX_MAGIC 0x58445750 // "PWDX"
+#define REPLAY_INDEX_VERSION 3
+
+#define REPLAY_INDEX_BLOCK_GAMES 1024
+
+// Longest replay file name that can be indexed, including the terminator
+#define REPLAY_INDEX_NAME_LENGTH 32
+
+// Columns that can be filtered on
+typedef enum ReplayIndexColumn {
+    ReplayIndexSeed,
+    ReplayIndexInitialDifficulty,
+    ReplayIndexScore,
+    ReplayIndexCompletedLines,
+    ReplayIndexDifficulty,
+    ReplayIndexFrames,
+    ReplayIndexPieces,
+    // REPLAY_FLAG_ rule variations, so games played with other rules can be kept apart
+    ReplayIndexFlags,
+    ReplayIndexColumnCount
+} ReplayIndexColumn;
+
+typedef struct ReplayIndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockGames;
+    uint32_t blockSize;
+
+    uint64_t numGames;
+
+    uint8_t reserved[40];
+} ReplayIndexHeader;
+
+typedef struct ReplayIndexBlock {
+    uint32_t columns[ReplayIndexColumnCount][REPLAY_INDEX_BLOCK_GAMES];
+
+    // File name of the replay within the archive directory
+    char name[REPLAY_INDEX_BLOCK_GAMES][REPLAY_INDEX_NAME_LENGTH];
+} ReplayIndexBlock;
+
+typedef struct ReplayIndex {
+    const ReplayIndexBlock* blocks;
+    uint64_t numGames;
+
+    void* map;
+    size_t mapSize;
+} ReplayIndex;
+
+// Inclusive range of values allowed for each column
+typedef struct ReplayIndexFilter {
+    uint32_t min[ReplayIndexColumnCount];
+    uint32_t max[ReplayIndexColumnCount];
+} ReplayIndexFilter;
+
+// Called for each game matching a query
+typedef void (*ReplayIndexMatchCallback)(const ReplayIndex* index, uint64_t game, void* userdata);
+
+// Add every replay in a directory that isn't already in the index. The index is created if it doesn't exist
+// Returns the number of games added, or -1 if the index couldn't be written
+long replayIndexUpdate(const char* indexPath, const char* directory);
+
+// Map an index for reading
+ReplayIndex* replayIndexOpen(const char* path);
+
+// Unmap and deallocate an index
+void replayIndexClose(ReplayIndex* index);
+
+// Set a filter to match every game
+void replayIndexFilterInit(ReplayIndexFilter* filter);
+
+// Limit a column of a filter to [min, max]
+void replayIndexFilterSet(ReplayIndexFilter* filter, ReplayIndexColumn column, uint32_t min, uint32_t max);
+
+// Find every game matching a filter. The callback may be NULL to only count them
+// Returns the number of matching games
+uint64_t replayIndexQuery(const ReplayIndex* index, const ReplayIndexFilter* filter, ReplayIndexMatchCallback callback, void* userdata);
+
+// Get a column value of a game
+static inline uint32_t replayIndexValue(const ReplayIndex* index, uint64_t game, ReplayIndexColumn column) {
+    return index->blocks[game / REPLAY_INDEX_BLOCK_GAMES].columns[column][game % REPLAY_INDEX_BLOCK_GAMES];
+}
+
+// Get the file name of a game
+static inline const char* replayIndexName(const ReplayIndex* index, uint64_t game) {
+    return index->blocks[game / REPLAY_INDEX_BLOCK_GAMES].name[game % REPLAY_INDEX_BLOCK_GAMES];
+}
+
+#endif
\ No newline at end of file
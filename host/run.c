@@ -0,0 +1,184 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "env.h"
+#include "rand.h"
+#include "trajectory.h"
+
+// Steps a batch of games driven by random button presses and exports their trajectories
+// Finished games are restarted with a new seed so every board keeps producing records
+
+typedef struct RunOptions {
+    int numBoards;
+    int numFrames;
+    int numThreads;
+    unsigned int seed;
+    int difficulty;
+    bool perPiece;
+    const char* output;
+} RunOptions;
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -n boards     Number of boards stepped together (default 1024)\n"
+        "  -f frames     Number of frames to step (default 3000)\n"
+        "  -t threads    Number of threads (default 1)\n"
+        "  -s seed       Seed used to pick game seeds and buttons (default 1)\n"
+        "  -l level      Starting level (default 0)\n"
+        "  -o file       Append trajectory records to this file\n"
+        "  -p            Write one record per locked piece rather than one per frame\n",
+        name);
+}
+
+// Pick the buttons held on the next frame. Buttons tend to be held for a few frames
+static uint8_t nextButtons(unsigned int* rng, uint8_t previous) {
+    *rng = rand_advance(*rng);
+
+    unsigned int roll = (*rng >> 8) % 16;
+
+    if (roll < 10) {
+        return previous;
+    } else if (roll < 12) {
+        return 0;
+    } else {
+        return previous ^ (1 << ((*rng >> 16) % 6));
+    }
+}
+
+int main(int argc, char** argv) {
+    RunOptions options = {
+        .numBoards = 1024,
+        .numFrames = 3000,
+        .numThreads = 1,
+        .seed = 1,
+        .difficulty = 0,
+        .perPiece = false,
+        .output = NULL
+    };
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:f:t:s:l:o:p")) != -1) {
+        switch (opt) {
+            case 'n':
+                options.numBoards = atoi(optarg);
+                break;
+            case 'f':
+                options.numFrames = atoi(optarg);
+                break;
+            case 't':
+                options.numThreads = atoi(optarg);
+                break;
+            case 's':
+                options.seed = (unsigned int)strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                options.difficulty = atoi(optarg);
+                break;
+            case 'o':
+                options.output = optarg;
+                break;
+            case 'p':
+                options.perPiece = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (options.numBoards <= 0 || options.numFrames <= 0 || options.numThreads <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Env* env = envCreate(options.numBoards, options.numThreads);
+    uint8_t* current = calloc(options.numBoards, sizeof(uint8_t));
+    uint8_t* pushed = calloc(options.numBoards, sizeof(uint8_t));
+    uint32_t* lastPieces = calloc(options.numBoards, sizeof(uint32_t));
+
+    if (env == NULL || current == NULL || pushed == NULL || lastPieces == NULL) {
+        fprintf(stderr, "Unable to create %d boards on %d threads\n", options.numBoards, options.numThreads);
+        return 1;
+    }
+
+    TrajectoryWriter* writer = NULL;
+
+    if (options.output != NULL) {
+        writer = trajectoryWriterOpen(options.output);
+
+        if (writer == NULL) {
+            fprintf(stderr, "Unable to open '%s' for writing\n", options.output);
+            return 1;
+        }
+    }
+
+    unsigned int rng = options.seed;
+    unsigned long gamesFinished = 0;
+
+    for (int board = 0; board < options.numBoards; board++) {
+        rng = rand_advance(rng);
+        envReset(env, board, rng, options.difficulty);
+    }
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    for (int frame = 0; frame < options.numFrames; frame++) {
+        for (int board = 0; board < options.numBoards; board++) {
+            uint8_t buttons = nextButtons(&rng, current[board]);
+
+            pushed[board] = buttons & ~current[board];
+            current[board] = buttons;
+        }
+
+        envStep(env, current, pushed);
+
+        for (int board = 0; board < options.numBoards; board++) {
+            if (writer != NULL) {
+                if (!options.perPiece) {
+                    trajectoryWriteEnv(writer, env, board, current[board], pushed[board]);
+                } else if (env->pieces[board] != lastPieces[board]) {
+                    trajectoryWriteEnv(writer, env, board, current[board], pushed[board]);
+                    lastPieces[board] = env->pieces[board];
+                }
+            }
+
+            if (envIsFinished(env, board)) {
+                gamesFinished++;
+
+                rng = rand_advance(rng);
+                envReset(env, board, rng, options.difficulty);
+                lastPieces[board] = 0;
+            }
+        }
+    }
+
+    struct timespec finished;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+
+    double seconds = (double)(finished.tv_sec - started.tv_sec) + ((double)(finished.tv_nsec - started.tv_nsec) / 1e9);
+    double steps = (double)options.numBoards * options.numFrames;
+
+    printf("Stepped %.0f board frames in %.3fs (%.1fM/s), %lu games finished\n", steps, seconds, steps / seconds / 1e6, gamesFinished);
+
+    if (writer != NULL) {
+        uint64_t records = trajectoryWriterCount(writer);
+
+        if (!trajectoryWriterClose(writer)) {
+            fprintf(stderr, "Error writing '%s'\n", options.output);
+            return 1;
+        }
+
+        printf("Wrote %llu records (%.1fM/s)\n", (unsigned long long)records, (double)records / seconds / 1e6);
+    }
+
+    envDestroy(env);
+    free(current);
+    free(pushed);
+    free(lastPieces);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trajectory.h"
+
+// Records held in memory before they are written out
+#define TRAJECTORY_BUFFER_RECORDS 8192
+
+_Static_assert(sizeof(TrajectoryHeader) == 64, "Trajectory header must keep records aligned");
+_Static_assert(sizeof(TrajectoryRecord) == 64, "Trajectory records must be 64 bytes");
+
+struct TrajectoryWriter {
+    int fd;
+
+    TrajectoryRecord* buffer;
+    int buffered;
+
+    uint64_t written;
+
+    // Set once any write fails, since records in a failed flush are lost
+    bool failed;
+};
+
+// Write a whole buffer, retrying on short writes
+static bool writeAll(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+
+    while (size > 0) {
+        ssize_t count = write(fd, bytes, size);
+
+        if (count <= 0) {
+            return false;
+        }
+
+        bytes += count;
+        size -= (size_t)count;
+    }
+
+    return true;
+}
+
+// Returns whether a header has a layout this build can read, in a file of the given size
+static bool validHeader(const TrajectoryHeader* header, size_t fileSize) {
+    return header->magic == TRAJECTORY_MAGIC
+        && header->version == TRAJECTORY_VERSION
+        && header->recordSize == sizeof(TrajectoryRecord)
+        && header->headerSize >= sizeof(TrajectoryHeader)
+        && header->headerSize <= fileSize;
+}
+
+// Open a file for writing. Records are appended if the file already exists
+TrajectoryWriter* trajectoryWriterOpen(const char* path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    if (info.st_size == 0) {
+        TrajectoryHeader header = {
+            .magic = TRAJECTORY_MAGIC,
+            .version = TRAJECTORY_VERSION,
+            .headerSize = sizeof(TrajectoryHeader),
+            .recordSize = sizeof(TrajectoryRecord)
+        };
+
+        if (!writeAll(fd, &header, sizeof(header))) {
+            close(fd);
+            return NULL;
+        }
+    } else {
+        // Only append to files with a matching layout
+        TrajectoryHeader header;
+
+        if (pread(fd, &header, sizeof(header), 0) != sizeof(header)
+            || !validHeader(&header, (size_t)info.st_size)
+            || (((size_t)info.st_size - header.headerSize) % header.recordSize) != 0) {
+            close(fd);
+            return NULL;
+        }
+    }
+
+    TrajectoryWriter* writer = calloc(1, sizeof(TrajectoryWriter));
+
+    if (writer == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    writer->fd = fd;
+    writer->buffer = aligned_alloc(64, TRAJECTORY_BUFFER_RECORDS * sizeof(TrajectoryRecord));
+
+    if (writer->buffer == NULL) {
+        free(writer);
+        close(fd);
+        return NULL;
+    }
+
+    return writer;
+}
+
+// Get the next free record in the write buffer. The record is written out once the buffer fills up
+TrajectoryRecord* trajectoryWriterNext(TrajectoryWriter* writer) {
+    if (writer->buffered == TRAJECTORY_BUFFER_RECORDS) {
+        trajectoryWriterFlush(writer);
+    }
+
+    writer->written++;
+
+    return &writer->buffer[writer->buffered++];
+}
+
+// Append the current state of a board
+void trajectoryWriteEnv(TrajectoryWriter* writer, const Env* env, int board, uint8_t current, uint8_t pushed) {
+    trajectoryRecordFromEnv(trajectoryWriterNext(writer), env, board, current, pushed);
+}
+
+// Write out any buffered records
+bool trajectoryWriterFlush(TrajectoryWriter* writer) {
+    bool ok = writeAll(writer->fd, writer->buffer, (size_t)writer->buffered * sizeof(TrajectoryRecord));
+
+    writer->buffered = 0;
+
+    if (!ok) {
+        writer->failed = true;
+    }
+
+    return ok;
+}
+
+// Flush, close and deallocate a writer
+// Returns false if any write since the writer was opened failed
+bool trajectoryWriterClose(TrajectoryWriter* writer) {
+    trajectoryWriterFlush(writer);
+
+    bool ok = (close(writer->fd) == 0) && !writer->failed;
+
+    free(writer->buffer);
+    free(writer);
+
+    return ok;
+}
+
+// Number of records written since the writer was opened
+uint64_t trajectoryWriterCount(const TrajectoryWriter* writer) {
+    return writer->written;
+}
+
+// Map a file for reading
+TrajectoryReader* trajectoryReaderOpen(const char* path) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TrajectoryHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const TrajectoryHeader* header = map;
+
+    if (!validHeader(header, (size_t)info.st_size)) {
+        munmap(map, (size_t)info.st_size);
+        return NULL;
+    }
+
+    TrajectoryReader* reader = calloc(1, sizeof(TrajectoryReader));
+
+    if (reader == NULL) {
+        munmap(map, (size_t)info.st_size);
+        return NULL;
+    }
+
+    reader->map = map;
+    reader->mapSize = (size_t)info.st_size;
+    reader->records = (const TrajectoryRecord*)((const uint8_t*)map + header->headerSize);
+
+    // A partly written trailing record is ignored
+    reader->numRecords = (reader->mapSize - header->headerSize) / header->recordSize;
+
+    return reader;
+}
+
+// Unmap and deallocate a reader
+void trajectoryReaderClose(TrajectoryReader* reader) {
+    munmap(reader->map, reader->mapSize);
+    free(reader);
+}
+
+// Fill a record from the current state of a board
+void trajectoryRecordFromEnv(TrajectoryRecord* record, const Env* env, int board, uint8_t current, uint8_t pushed) {
+    const BitboardRow* rows = &env->rows[board * BITBOARD_STRIDE];
+
+    for (int word = 0; word < MATRIX_GRID_ROWS / TRAJECTORY_ROWS_PER_WORD; word++) {
+        uint64_t packed = 0;
+
+        for (int i = 0; i < TRAJECTORY_ROWS_PER_WORD; i++) {
+            packed |= (uint64_t)rows[(word * TRAJECTORY_ROWS_PER_WORD) + i] << (i * MATRIX_GRID_COLS);
+        }
+
+        record->matrix[word] = packed;
+    }
+
+    record->board = (uint32_t)board;
+    record->frame = env->frames[board];
+    record->score = env->score[board];
+    record->completedLines = env->completedLines[board];
+    record->difficulty = (uint16_t)env->difficulty[board];
+    record->status = env->status[board];
+    record->piece = env->piece[board];
+    record->standbyPiece = env->standbyPiece[board];
+    record->pieceRow = env->pieceRow[board];
+    record->pieceCol = env->pieceCol[board];
+    record->pieceOrientation = env->pieceOrientation[board];
+    record->current = current;
+    record->pushed = pushed;
+    memset(record->reserved, 0, sizeof(record->reserved));
+}
\ No newline at end of file
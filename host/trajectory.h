@@ -0,0 +1,106 @@
+#ifndef HOST_TRAJECTORY_H
+#define HOST_TRAJECTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "env.h"
+
+// Trajectory files hold fixed size records of board state, one per frame or per piece.
+// The file is a header followed by records and is only ever appended to, so the number of
+// records is taken from the file size. Readers map the file and index records directly.
+
+#define TRAJECTORY_MAGIC 0x4A525450 // "PTRJ"
+#define TRAJECTORY_VERSION 1
+
+// Rows of the matrix packed into each 64-bit word of a record
+#define TRAJECTORY_ROWS_PER_WORD 6
+
+typedef struct TrajectoryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t recordSize;
+
+    // Pads the header so records stay 64-byte aligned in the mapped file
+    uint8_t reserved[48];
+} TrajectoryHeader;
+
+typedef struct TrajectoryRecord {
+    // Locked cells, MATRIX_GRID_COLS bits per row and TRAJECTORY_ROWS_PER_WORD rows per word
+    // Row N is at bit (N % 6) * 10 of word N / 6
+    uint64_t matrix[MATRIX_GRID_ROWS / TRAJECTORY_ROWS_PER_WORD];
+
+    // Board the record came from and the frame number within its game
+    uint32_t board;
+    uint32_t frame;
+
+    int32_t score;
+    int32_t completedLines;
+    uint16_t difficulty;
+    uint8_t status;
+
+    int8_t piece;
+    int8_t standbyPiece;
+    int8_t pieceRow;
+    int8_t pieceCol;
+    int8_t pieceOrientation;
+
+    // Buttons held and pressed on the frame
+    uint8_t current;
+    uint8_t pushed;
+
+    uint8_t reserved[6];
+} TrajectoryRecord;
+
+typedef struct TrajectoryWriter TrajectoryWriter;
+
+typedef struct TrajectoryReader {
+    const TrajectoryRecord* records;
+    uint64_t numRecords;
+
+    void* map;
+    size_t mapSize;
+} TrajectoryReader;
+
+// Open a file for writing. Records are appended if the file already exists
+TrajectoryWriter* trajectoryWriterOpen(const char* path);
+
+// Get the next free record in the write buffer. The record is written out once the buffer fills up
+TrajectoryRecord* trajectoryWriterNext(TrajectoryWriter* writer);
+
+// Append the current state of a board
+void trajectoryWriteEnv(TrajectoryWriter* writer, const Env* env, int board, uint8_t current, uint8_t pushed);
+
+// Write out any buffered records
+bool trajectoryWriterFlush(TrajectoryWriter* writer);
+
+// Flush, close and deallocate a writer
+// Returns false if any write since the writer was opened failed
+bool trajectoryWriterClose(TrajectoryWriter* writer);
+
+// Number of records written since the writer was opened
+uint64_t trajectoryWriterCount(const TrajectoryWriter* writer);
+
+// Map a file for reading
+TrajectoryReader* trajectoryReaderOpen(const char* path);
+
+// Unmap and deallocate a reader
+void trajectoryReaderClose(TrajectoryReader* reader);
+
+// Fill a record from the current state of a board
+void trajectoryRecordFromEnv(TrajectoryRecord* record, const Env* env, int board, uint8_t current, uint8_t pushed);
+
+// Get a record by index
+static inline const TrajectoryRecord* trajectoryRecordAt(const TrajectoryReader* reader, uint64_t index) {
+    return index < reader->numRecords ? &reader->records[index] : NULL;
+}
+
+// Get a row of a record's matrix (bit N is column N)
+static inline BitboardRow trajectoryRecordRow(const TrajectoryRecord* record, int row) {
+    uint64_t word = record->matrix[row / TRAJECTORY_ROWS_PER_WORD];
+
+    return (BitboardRow)((word >> ((row % TRAJECTORY_ROWS_PER_WORD) * MATRIX_GRID_COLS)) & BITBOARD_FULL_ROW);
+}
+
+#endif
\ No newline at end of file
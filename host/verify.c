@@ -0,0 +1,415 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "env.h"
+#include "scenes/board/replayFormat.h"
+
+// Replays every recorded game in a directory and checks the results match what the device saved
+// Each thread steps a batch of replays together, one frame at a time
+
+// Replays stepped together by a thread
+#define VERIFY_BATCH_SIZE ENV_SHARD_ALIGNMENT
+
+typedef enum VerifyResult {
+    VerifyPending,
+    VerifyMatched,
+    VerifyMismatched,
+    VerifyUnreadable,
+    VerifyUnsupported
+} VerifyResult;
+
+// A replay file and the results of replaying it
+typedef struct VerifyReplay {
+    char* path;
+
+    void* map;
+    size_t mapSize;
+    const ReplayFrame* frames;
+
+    // Copy of the header, kept after the file is unmapped
+    ReplayHeader header;
+
+    VerifyResult result;
+
+    // Results from the simulation
+    uint32_t score;
+    uint32_t completedLines;
+    uint32_t difficulty;
+    uint32_t pieces;
+    // Frame the game ended on, or zero if it didn't end early
+    uint32_t endedFrame;
+    // Whether the game had ended after the last recorded frame
+    bool finished;
+} VerifyReplay;
+
+typedef struct VerifyJob {
+    VerifyReplay* replays;
+    int numReplays;
+
+    // Next replay to be handed out
+    atomic_int next;
+} VerifyJob;
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "Usage: %s [options] directory\n"
+        "  -t threads    Number of threads (default 1)\n"
+        "  -v            List every replay, not just mismatches\n",
+        name);
+}
+
+static bool hasReplayExtension(const char* name) {
+    size_t length = strlen(name);
+    size_t extensionLength = strlen(REPLAY_EXTENSION);
+
+    return length > extensionLength && strcmp(name + length - extensionLength, REPLAY_EXTENSION) == 0;
+}
+
+// Collect the paths of every replay in a directory
+static VerifyReplay* findReplays(const char* directory, int* numReplays) {
+    DIR* dir = opendir(directory);
+
+    if (dir == NULL) {
+        return NULL;
+    }
+
+    VerifyReplay* replays = NULL;
+    int count = 0;
+    int capacity = 0;
+    struct dirent* entry;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (!hasReplayExtension(entry->d_name)) {
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 256;
+            replays = realloc(replays, (size_t)capacity * sizeof(VerifyReplay));
+        }
+
+        size_t pathLength = strlen(directory) + strlen(entry->d_name) + 2;
+
+        replays[count] = (VerifyReplay){ .result = VerifyPending };
+        replays[count].path = malloc(pathLength);
+        snprintf(replays[count].path, pathLength, "%s/%s", directory, entry->d_name);
+
+        count++;
+    }
+
+    closedir(dir);
+
+    *numReplays = count;
+
+    return replays;
+}
+
+// Map a replay file and validate its header
+static VerifyResult openReplay(VerifyReplay* replay) {
+    int fd = open(replay->path, O_RDONLY);
+
+    if (fd < 0) {
+        return VerifyUnreadable;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ReplayHeader)) {
+        close(fd);
+        return VerifyUnreadable;
+    }
+
+    void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return VerifyUnreadable;
+    }
+
+    replay->map = map;
+    replay->mapSize = (size_t)info.st_size;
+    replay->frames = (const ReplayFrame*)((const uint8_t*)map + sizeof(ReplayHeader));
+    memcpy(&replay->header, map, sizeof(ReplayHeader));
+
+    const ReplayHeader* header = &replay->header;
+    size_t expectedSize = sizeof(ReplayHeader) + ((size_t)header->numFrames * sizeof(ReplayFrame));
+
+    if (header->magic != REPLAY_MAGIC || header->version != REPLAY_VERSION || replay->mapSize != expectedSize) {
+        return VerifyUnreadable;
+    }
+
+    // Rule variations aren't simulated by the environment
+    if (header->flags != 0) {
+        return VerifyUnsupported;
+    }
+
+    return VerifyPending;
+}
+
+static void closeReplay(VerifyReplay* replay) {
+    if (replay->map != NULL) {
+        munmap(replay->map, replay->mapSize);
+        replay->map = NULL;
+    }
+}
+
+// Copy a board's results into its replay
+static void captureResults(VerifyReplay* replay, const Env* env, int board) {
+    replay->score = (uint32_t)env->score[board];
+    replay->completedLines = (uint32_t)env->completedLines[board];
+    replay->difficulty = (uint32_t)env->difficulty[board];
+    replay->pieces = env->pieces[board];
+    replay->finished = envIsFinished(env, board);
+
+    const ReplayHeader* header = &replay->header;
+
+    // Replays are only saved once the game ends, so it must end on the last frame and not before
+    bool matched = replay->endedFrame == 0
+        && replay->finished
+        && replay->score == header->score
+        && replay->completedLines == header->completedLines
+        && replay->difficulty == header->difficulty
+        && replay->pieces == header->pieces;
+
+    replay->result = matched ? VerifyMatched : VerifyMismatched;
+}
+
+// Step a batch of replays together until the longest one runs out of frames
+static void verifyBatch(Env* env, VerifyReplay** batch, int count, uint8_t* current, uint8_t* pushed) {
+    uint32_t maxFrames = 0;
+
+    for (int board = 0; board < count; board++) {
+        envReset(env, board, batch[board]->header.seed, (int)batch[board]->header.initialDifficulty);
+
+        if (batch[board]->header.numFrames > maxFrames) {
+            maxFrames = batch[board]->header.numFrames;
+        }
+
+        // Nothing to step for empty games
+        if (batch[board]->header.numFrames == 0) {
+            captureResults(batch[board], env, board);
+        }
+    }
+
+    for (uint32_t frame = 0; frame < maxFrames; frame++) {
+        for (int board = 0; board < count; board++) {
+            VerifyReplay* replay = batch[board];
+
+            if (frame < replay->header.numFrames) {
+                current[board] = replay->frames[frame].current;
+                pushed[board] = replay->frames[frame].pushed;
+
+                // The device stops recording once the game ends
+                if (envIsFinished(env, board) && replay->endedFrame == 0) {
+                    replay->endedFrame = frame;
+                }
+            } else {
+                current[board] = 0;
+                pushed[board] = 0;
+            }
+        }
+
+        envStepRange(env, 0, count, current, pushed);
+
+        for (int board = 0; board < count; board++) {
+            if (frame + 1 == batch[board]->header.numFrames) {
+                captureResults(batch[board], env, board);
+            }
+        }
+    }
+}
+
+static void* verifyWorker(void* data) {
+    VerifyJob* job = (VerifyJob*)data;
+
+    Env* env = envCreate(VERIFY_BATCH_SIZE, 1);
+    VerifyReplay* batch[VERIFY_BATCH_SIZE];
+    uint8_t current[VERIFY_BATCH_SIZE];
+    uint8_t pushed[VERIFY_BATCH_SIZE];
+
+    // Other threads pick up the replays. Any nobody could step are left pending and reported
+    if (env == NULL) {
+        fprintf(stderr, "Unable to create the simulation for a verify thread\n");
+        return NULL;
+    }
+
+    for (;;) {
+        int first = atomic_fetch_add(&job->next, VERIFY_BATCH_SIZE);
+
+        if (first >= job->numReplays) {
+            break;
+        }
+
+        int last = first + VERIFY_BATCH_SIZE < job->numReplays ? first + VERIFY_BATCH_SIZE : job->numReplays;
+        int count = 0;
+
+        for (int i = first; i < last; i++) {
+            VerifyReplay* replay = &job->replays[i];
+
+            replay->result = openReplay(replay);
+
+            if (replay->result == VerifyPending) {
+                batch[count++] = replay;
+            } else {
+                closeReplay(replay);
+            }
+        }
+
+        verifyBatch(env, batch, count, current, pushed);
+
+        for (int i = 0; i < count; i++) {
+            closeReplay(batch[i]);
+        }
+    }
+
+    envDestroy(env);
+
+    return NULL;
+}
+
+static void printReplay(const VerifyReplay* replay) {
+    const ReplayHeader* header = &replay->header;
+
+    switch (replay->result) {
+        case VerifyMatched:
+            printf("ok        %s\n", replay->path);
+            break;
+
+        case VerifyMismatched:
+            printf("MISMATCH  %s\n", replay->path);
+            printf("          score %u/%u, lines %u/%u, level %u/%u, pieces %u/%u (saved/replayed)\n",
+                header->score, replay->score,
+                header->completedLines, replay->completedLines,
+                header->difficulty, replay->difficulty,
+                header->pieces, replay->pieces);
+
+            if (replay->endedFrame != 0) {
+                printf("          game ended on frame %u of %u\n", replay->endedFrame, header->numFrames);
+            } else if (!replay->finished) {
+                printf("          recording ends before the game does\n");
+            }
+            break;
+
+        case VerifyUnsupported:
+            printf("skipped   %s (unsupported rules)\n", replay->path);
+            break;
+
+        case VerifyPending:
+            printf("ERROR     %s (not verified)\n", replay->path);
+            break;
+
+        default:
+            printf("ERROR     %s (unreadable)\n", replay->path);
+            break;
+    }
+}
+
+int main(int argc, char** argv) {
+    int numThreads = 1;
+    bool verbose = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:v")) != -1) {
+        switch (opt) {
+            case 't':
+                numThreads = atoi(optarg);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (optind != argc - 1 || numThreads <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* directory = argv[optind];
+    int numReplays = 0;
+    VerifyReplay* replays = findReplays(directory, &numReplays);
+
+    if (replays == NULL && numReplays == 0) {
+        DIR* dir = opendir(directory);
+
+        if (dir == NULL) {
+            fprintf(stderr, "Unable to read directory '%s'\n", directory);
+            return 1;
+        }
+
+        closedir(dir);
+    }
+
+    VerifyJob job = {
+        .replays = replays,
+        .numReplays = numReplays
+    };
+    atomic_init(&job.next, 0);
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    pthread_t* threads = calloc((size_t)numThreads, sizeof(pthread_t));
+    int startedThreads = 1;
+
+    // Replays are shared out as threads ask for them, so fewer threads only makes verifying slower
+    while (threads != NULL && startedThreads < numThreads && pthread_create(&threads[startedThreads], NULL, verifyWorker, &job) == 0) {
+        startedThreads++;
+    }
+
+    verifyWorker(&job);
+
+    for (int i = 1; i < startedThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    struct timespec finished;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+
+    double seconds = (double)(finished.tv_sec - started.tv_sec) + ((double)(finished.tv_nsec - started.tv_nsec) / 1e9);
+
+    int counts[VerifyUnsupported + 1] = { 0 };
+    unsigned long long totalFrames = 0;
+    unsigned long long totalBytes = 0;
+
+    for (int i = 0; i < numReplays; i++) {
+        VerifyReplay* replay = &replays[i];
+
+        counts[replay->result]++;
+
+        if (replay->result == VerifyMatched || replay->result == VerifyMismatched) {
+            totalFrames += replay->header.numFrames;
+            totalBytes += replay->mapSize;
+        }
+
+        if (verbose || replay->result != VerifyMatched) {
+            printReplay(replay);
+        }
+    }
+
+    printf("Verified %d replays (%llu frames) in %.3fs (%.1fMB/s, %.1fM frames/s)\n",
+        numReplays, totalFrames, seconds, (double)totalBytes / seconds / 1e6, (double)totalFrames / seconds / 1e6);
+    printf("%d matched, %d mismatched, %d unreadable, %d skipped\n",
+        counts[VerifyMatched], counts[VerifyMismatched], counts[VerifyUnreadable], counts[VerifyUnsupported]);
+
+    for (int i = 0; i < numReplays; i++) {
+        free(replays[i].path);
+    }
+
+    free(replays);
+    free(threads);
+
+    return (counts[VerifyMismatched] > 0 || counts[VerifyUnreadable] > 0 || counts[VerifyPending] > 0) ? 1 : 0;
+}
\ No newline at end of file
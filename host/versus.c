@@ -0,0 +1,507 @@
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "env.h"
+#include "rand.h"
+
+// Two player games over a local socket with rollback.
+// Each side runs both boards and only sends its own buttons. Buttons from the other side are predicted
+// until they arrive, and if the prediction was wrong the other side's board is rewound to the frame the
+// buttons were for and stepped forward again. Packets are held back by the sender to stand in for a
+// real link's latency.
+
+// Furthest a side can get ahead of the last buttons it has from the other side
+#define VERSUS_MAX_ROLLBACK_FRAMES 12
+
+// Snapshots kept for rewinding, one per frame
+#define VERSUS_SNAPSHOTS 16
+
+// Packets held back by the sender while they're "in flight"
+#define VERSUS_MAX_IN_FLIGHT 1024
+
+// Nanoseconds per frame at 50 FPS
+#define VERSUS_FRAME_NS 20000000L
+
+_Static_assert(VERSUS_SNAPSHOTS > VERSUS_MAX_ROLLBACK_FRAMES, "Snapshots must cover the rollback window");
+
+typedef enum VersusPacketType {
+    VersusButtons,
+    VersusChecksum
+} VersusPacketType;
+
+typedef struct VersusPacket {
+    uint32_t type;
+    uint32_t frame;
+
+    uint8_t current;
+    uint8_t pushed;
+    uint8_t reserved[2];
+
+    uint32_t checksum;
+} VersusPacket;
+
+typedef struct VersusOptions {
+    int numFrames;
+    unsigned int seed;
+    int difficulty;
+    int latencyMs;
+    int jitterMs;
+    bool realTime;
+} VersusOptions;
+
+// State of one side of the link
+typedef struct VersusSide {
+    int player;
+    int socket;
+    const VersusOptions* options;
+
+    // Board 0 belongs to player 0 and board 1 to player 1
+    Env* env;
+
+    // Buttons of both players for every frame, indexed by [frame][player]
+    // The other player's buttons are predicted until they're confirmed
+    uint8_t (*current)[2];
+    uint8_t (*pushed)[2];
+
+    // Last frame the other player's buttons are known for
+    int confirmedFrame;
+
+    // Next frame to be stepped
+    int frame;
+
+    // Snapshots of the other player's board taken before stepping each frame
+    EnvSnapshot snapshots[VERSUS_SNAPSHOTS];
+
+    // Packets waiting to be delivered, and the time each one is due
+    VersusPacket inFlight[VERSUS_MAX_IN_FLIGHT];
+    uint64_t inFlightDue[VERSUS_MAX_IN_FLIGHT];
+    int inFlightFirst;
+    int inFlightCount;
+
+    unsigned int rng;
+
+    // Stats
+    unsigned long rollbacks;
+    unsigned long resimulatedFrames;
+    int longestRollback;
+    uint64_t rollbackNs;
+    uint64_t longestRollbackNs;
+    unsigned long stalls;
+} VersusSide;
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -f frames     Number of frames to play (default 3000)\n"
+        "  -s seed       Game seed (default 1)\n"
+        "  -l level      Starting level (default 0)\n"
+        "  -d ms         Latency added to every packet (default 60)\n"
+        "  -j ms         Random extra latency added to packets (default 20)\n"
+        "  -r            Pace frames at 50 FPS instead of running flat out\n",
+        name);
+}
+
+static uint64_t nowNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+// Pick the buttons held on the next frame. Buttons tend to be held for a few frames
+static uint8_t nextButtons(unsigned int* rng, uint8_t previous) {
+    *rng = rand_advance(*rng);
+
+    unsigned int roll = (*rng >> 8) % 16;
+
+    if (roll < 10) {
+        return previous;
+    } else if (roll < 12) {
+        return 0;
+    } else {
+        return previous ^ (1 << ((*rng >> 16) % 6));
+    }
+}
+
+// Hash of both boards, compared by the two sides at the end of the game
+static uint32_t checksumBoards(const Env* env) {
+    uint32_t hash = 2166136261u;
+
+    for (int board = 0; board < 2; board++) {
+        EnvSnapshot snapshot;
+        envSnapshot(env, board, &snapshot);
+
+        // Stop before any trailing padding
+        const uint8_t* bytes = (const uint8_t*)&snapshot;
+        size_t size = offsetof(EnvSnapshot, hardDropStartingRow) + sizeof(snapshot.hardDropStartingRow);
+
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+// Hold a packet back until its latency has passed. Packets are never reordered
+static void sendPacket(VersusSide* side, const VersusPacket* packet) {
+    const VersusOptions* options = side->options;
+
+    side->rng = rand_advance(side->rng);
+
+    uint64_t jitter = options->jitterMs > 0 ? (side->rng >> 8) % (unsigned int)(options->jitterMs + 1) : 0;
+    uint64_t due = nowNs() + (((uint64_t)options->latencyMs + jitter) * 1000000ULL);
+
+    if (side->inFlightCount > 0) {
+        int last = (side->inFlightFirst + side->inFlightCount - 1) % VERSUS_MAX_IN_FLIGHT;
+
+        if (due < side->inFlightDue[last]) {
+            due = side->inFlightDue[last];
+        }
+    }
+
+    int slot = (side->inFlightFirst + side->inFlightCount) % VERSUS_MAX_IN_FLIGHT;
+
+    side->inFlight[slot] = *packet;
+    side->inFlightDue[slot] = due;
+    side->inFlightCount++;
+}
+
+// Deliver every held back packet whose latency has passed
+static void deliverPackets(VersusSide* side) {
+    uint64_t now = nowNs();
+
+    while (side->inFlightCount > 0 && side->inFlightDue[side->inFlightFirst] <= now) {
+        // Try again later rather than block if the other side hasn't caught up on reading
+        if (send(side->socket, &side->inFlight[side->inFlightFirst], sizeof(VersusPacket), MSG_DONTWAIT) != sizeof(VersusPacket)) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+
+            perror("send");
+            exit(1);
+        }
+
+        side->inFlightFirst = (side->inFlightFirst + 1) % VERSUS_MAX_IN_FLIGHT;
+        side->inFlightCount--;
+    }
+}
+
+// Time until the next held back packet is due, in milliseconds for poll
+static int nextDeliveryMs(const VersusSide* side) {
+    if (side->inFlightCount == 0) {
+        return 1;
+    }
+
+    uint64_t now = nowNs();
+    uint64_t due = side->inFlightDue[side->inFlightFirst];
+
+    return due > now ? (int)((due - now) / 1000000ULL) + 1 : 0;
+}
+
+// Step the other player's board forward again from a frame, using the buttons now known
+static void rollback(VersusSide* side, int fromFrame) {
+    int other = 1 - side->player;
+    uint64_t started = nowNs();
+
+    envRestore(side->env, other, &side->snapshots[fromFrame % VERSUS_SNAPSHOTS]);
+
+    for (int frame = fromFrame; frame < side->frame; frame++) {
+        // Later frames are still predicted from the latest confirmed buttons
+        if (frame > side->confirmedFrame) {
+            side->current[frame][other] = side->current[side->confirmedFrame][other];
+            side->pushed[frame][other] = 0;
+        }
+
+        envSnapshot(side->env, other, &side->snapshots[frame % VERSUS_SNAPSHOTS]);
+        envStepRange(side->env, other, other + 1, side->current[frame], side->pushed[frame]);
+    }
+
+    uint64_t elapsed = nowNs() - started;
+    int length = side->frame - fromFrame;
+
+    side->rollbacks++;
+    side->resimulatedFrames += (unsigned long)length;
+    side->rollbackNs += elapsed;
+
+    if (length > side->longestRollback) {
+        side->longestRollback = length;
+    }
+
+    if (elapsed > side->longestRollbackNs) {
+        side->longestRollbackNs = elapsed;
+    }
+}
+
+// Read every packet that has arrived. Returns the checksum packet if one was read
+static bool receivePackets(VersusSide* side, int timeoutMs, VersusPacket* checksum) {
+    int other = 1 - side->player;
+    int mispredictedFrame = -1;
+    bool gotChecksum = false;
+
+    struct pollfd fd = { .fd = side->socket, .events = POLLIN };
+
+    while (poll(&fd, 1, timeoutMs) > 0) {
+        VersusPacket packet;
+
+        if (recv(side->socket, &packet, sizeof(packet), 0) != sizeof(packet)) {
+            fprintf(stderr, "Player %d lost the link\n", side->player + 1);
+            exit(1);
+        }
+
+        if (packet.type == VersusChecksum) {
+            *checksum = packet;
+            gotChecksum = true;
+        } else {
+            int frame = (int)packet.frame;
+
+            // Buttons for frames already stepped were predicted. Rewind if the prediction was wrong
+            if (frame < side->frame && mispredictedFrame < 0
+                && (side->current[frame][other] != packet.current || side->pushed[frame][other] != packet.pushed)) {
+                mispredictedFrame = frame;
+            }
+
+            side->current[frame][other] = packet.current;
+            side->pushed[frame][other] = packet.pushed;
+            side->confirmedFrame = frame;
+        }
+
+        timeoutMs = 0;
+    }
+
+    if (mispredictedFrame >= 0) {
+        rollback(side, mispredictedFrame);
+    }
+
+    return gotChecksum;
+}
+
+// Step both boards one frame
+static void stepFrame(VersusSide* side) {
+    int frame = side->frame;
+    int other = 1 - side->player;
+
+    // Pick this side's buttons and send them
+    uint8_t previous = frame > 0 ? side->current[frame - 1][side->player] : 0;
+    uint8_t buttons = nextButtons(&side->rng, previous);
+
+    side->current[frame][side->player] = buttons;
+    side->pushed[frame][side->player] = buttons & ~previous;
+
+    VersusPacket packet = {
+        .type = VersusButtons,
+        .frame = (uint32_t)frame,
+        .current = side->current[frame][side->player],
+        .pushed = side->pushed[frame][side->player]
+    };
+
+    sendPacket(side, &packet);
+
+    // Predict the other player is still holding whatever they held last
+    if (frame > side->confirmedFrame) {
+        side->current[frame][other] = side->confirmedFrame >= 0 ? side->current[side->confirmedFrame][other] : 0;
+        side->pushed[frame][other] = 0;
+    }
+
+    envSnapshot(side->env, other, &side->snapshots[frame % VERSUS_SNAPSHOTS]);
+    envStep(side->env, side->current[frame], side->pushed[frame]);
+
+    side->frame++;
+}
+
+static int runSide(int player, int socket, const VersusOptions* options) {
+    VersusSide* side = calloc(1, sizeof(VersusSide));
+
+    if (side == NULL) {
+        fprintf(stderr, "Player %d: unable to allocate the game\n", player + 1);
+        return 1;
+    }
+
+    side->player = player;
+    side->socket = socket;
+    side->options = options;
+    side->env = envCreate(2, 1);
+    side->current = calloc((size_t)options->numFrames, sizeof(*side->current));
+    side->pushed = calloc((size_t)options->numFrames, sizeof(*side->pushed));
+
+    if (side->env == NULL || side->current == NULL || side->pushed == NULL) {
+        fprintf(stderr, "Player %d: unable to allocate the game\n", player + 1);
+
+        if (side->env != NULL) {
+            envDestroy(side->env);
+        }
+
+        free(side->current);
+        free(side->pushed);
+        free(side);
+        return 1;
+    }
+    side->confirmedFrame = -1;
+    side->rng = rand_advance(options->seed ^ (0x9E3779B9u * (unsigned int)(player + 1)));
+
+    for (int board = 0; board < 2; board++) {
+        envReset(side->env, board, options->seed, options->difficulty);
+    }
+
+    VersusPacket remoteChecksum;
+    bool gotChecksum = false;
+    uint64_t started = nowNs();
+
+    while (side->frame < options->numFrames) {
+        deliverPackets(side);
+        gotChecksum = receivePackets(side, 0, &remoteChecksum) || gotChecksum;
+
+        // Wait for the other side rather than predicting too far ahead
+        while (side->frame - side->confirmedFrame > VERSUS_MAX_ROLLBACK_FRAMES) {
+            side->stalls++;
+            deliverPackets(side);
+            gotChecksum = receivePackets(side, nextDeliveryMs(side), &remoteChecksum) || gotChecksum;
+        }
+
+        stepFrame(side);
+
+        if (options->realTime) {
+            uint64_t due = started + ((uint64_t)side->frame * VERSUS_FRAME_NS);
+            uint64_t now = nowNs();
+
+            if (due > now) {
+                struct timespec wait = { .tv_sec = 0, .tv_nsec = (long)(due - now) };
+                nanosleep(&wait, NULL);
+            }
+        }
+    }
+
+    // Wait for the rest of the other side's buttons so both sides end on the same state
+    while (side->confirmedFrame < options->numFrames - 1 || side->inFlightCount > 0) {
+        deliverPackets(side);
+        gotChecksum = receivePackets(side, nextDeliveryMs(side), &remoteChecksum) || gotChecksum;
+    }
+
+    uint32_t checksum = checksumBoards(side->env);
+
+    VersusPacket packet = {
+        .type = VersusChecksum,
+        .frame = (uint32_t)options->numFrames,
+        .checksum = checksum
+    };
+
+    if (send(socket, &packet, sizeof(packet), 0) != sizeof(packet)) {
+        perror("send");
+        return 1;
+    }
+
+    while (!gotChecksum) {
+        gotChecksum = receivePackets(side, -1, &remoteChecksum);
+    }
+
+    double seconds = (double)(nowNs() - started) / 1e9;
+    double averageUs = side->rollbacks > 0 ? (double)side->rollbackNs / (double)side->rollbacks / 1e3 : 0;
+    double perFrameUs = side->resimulatedFrames > 0 ? (double)side->rollbackNs / (double)side->resimulatedFrames / 1e3 : 0;
+
+    printf("Player %d: %d frames in %.2fs, score %d/%d, lines %d/%d\n",
+        player + 1, options->numFrames, seconds,
+        side->env->score[0], side->env->score[1], side->env->completedLines[0], side->env->completedLines[1]);
+    printf("Player %d: %lu rollbacks, %lu frames resimulated, longest %d frames (%.1fus), average %.1fus (%.2fus per frame), %lu stalls\n",
+        player + 1, side->rollbacks, side->resimulatedFrames, side->longestRollback,
+        (double)side->longestRollbackNs / 1e3, averageUs, perFrameUs, side->stalls);
+
+    bool inSync = remoteChecksum.checksum == checksum;
+
+    printf("Player %d: checksum %08X, other side %08X, %s\n", player + 1, checksum, remoteChecksum.checksum, inSync ? "in sync" : "DESYNCED");
+
+    envDestroy(side->env);
+    free(side->current);
+    free(side->pushed);
+    free(side);
+
+    return inSync ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    VersusOptions options = {
+        .numFrames = 3000,
+        .seed = 1,
+        .difficulty = 0,
+        .latencyMs = 60,
+        .jitterMs = 20,
+        .realTime = false
+    };
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:s:l:d:j:r")) != -1) {
+        switch (opt) {
+            case 'f':
+                options.numFrames = atoi(optarg);
+                break;
+            case 's':
+                options.seed = (unsigned int)strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                options.difficulty = atoi(optarg);
+                break;
+            case 'd':
+                options.latencyMs = atoi(optarg);
+                break;
+            case 'j':
+                options.jitterMs = atoi(optarg);
+                break;
+            case 'r':
+                options.realTime = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (options.numFrames <= 0 || options.latencyMs < 0 || options.jitterMs < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Datagrams keep packets whole and in order over a local socket
+    int sockets[2];
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+
+    // Flush before forking so buffered output isn't printed twice
+    fflush(stdout);
+
+    pid_t child = fork();
+
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    if (child == 0) {
+        close(sockets[0]);
+        return runSide(1, sockets[1], &options);
+    }
+
+    close(sockets[1]);
+
+    int result = runSide(0, sockets[0], &options);
+    int status;
+
+    while (waitpid(child, &status, 0) < 0 && errno == EINTR) {
+    }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        result = 1;
+    }
+
+    return result;
+}
\ No newline at end of file
@@ -1,12 +1,18 @@
 #include <stdbool.h>
+#include <stdio.h>
 #include "global.h"
 #include "form.h"
 #include "text.h"
+#include "game.h"
 
 #define FORM_SEED_CHARACTER_NUM_OPTIONS 16
 
-#define BUTTON_CHARGE_DELAY 19
-#define BUTTON_REPEAT_DELAY 7
+// Timings are in milliseconds and measured with the system clock, so they hold at any refresh rate
+#define BUTTON_CHARGE_DELAY 380
+#define BUTTON_REPEAT_DELAY 140
+
+// Time between switching the highlight of the focused field
+#define FOCUS_BLINK_DELAY 300
 
 static char SEED_CHARACTERS[FORM_SEED_CHARACTER_NUM_OPTIONS] = {
     '0',
@@ -56,13 +62,13 @@ typedef struct FormButtonField {
 // Create a new form
 Form* formCreate() {
     Form* form = SYS->realloc(NULL, sizeof(Form));
-    form->fieldListHead = NULL;
-    form->fieldListTail = NULL;
+    form->numFields = 0;
+    form->focusedIndex = -1;
     form->focusFrameCount = 0;
     form->focusFlipFlop = false;
 
     form->btnRepeat.buttons = 0;
-    form->btnRepeat.frames = 0;
+    form->btnRepeat.startedMs = 0;
     form->btnRepeat.isCharged = false;
 
     return form;
@@ -71,54 +77,63 @@ Form* formCreate() {
 // Reset button repeat state
 void formResetRepeat(Form* form) {
     form->btnRepeat.buttons = 0;
-    form->btnRepeat.frames = 0;
+    form->btnRepeat.startedMs = 0;
     form->btnRepeat.isCharged = false;
 }
 
-// Add a field to a form
-void formAddField(Form* form, FormField* field) {
-    FormFieldListItem* listItem = SYS->realloc(NULL, sizeof(FormFieldListItem));
-    listItem->field = field;
-    listItem->next = NULL;
-
-    // Is first item?
-    if (form->fieldListHead == NULL) {
-        form->fieldListHead = listItem;
-        form->fieldListTail = listItem;
-
-        // Make the first item the focused item
-        form->focusedFieldItem = listItem;
-    } else {
-        // Add as tail
-        FormFieldListItem* previousTail = form->fieldListTail;
-        previousTail->next = listItem;
-        form->fieldListTail = listItem;
+// Add a field to a form. The form takes a copy of the field and frees the one given
+// Returns the field held by the form, or NULL if the form is full
+FormField* formAddField(Form* form, FormField* field) {
+    if (form->numFields == FORM_MAX_FIELDS) {
+        SYS->logToConsole("Form is full, unable to add field");
+
+        SYS->realloc(field->details, 0);
+        SYS->realloc(field, 0);
+
+        return NULL;
+    }
+
+    FormField* added = &form->fields[form->numFields++];
+    *added = *field;
+    added->dirty = true;
+
+    SYS->realloc(field, 0);
+
+    // Make the first item the focused item
+    if (form->focusedIndex < 0) {
+        form->focusedIndex = 0;
     }
+
+    return added;
 }
 
-// Find the list item in the field list that contains the given field
-static FormFieldListItem* fieldInList(FormFieldListItem* head, FormField* field) {
-    for (FormFieldListItem* cur = head; cur != NULL; cur = cur->next) {
-        if (cur->field == field) {
-            return cur;
-        }
+// Move focus to the field at the given index, redrawing both the old and new fields
+static void focusIndex(Form* form, int index) {
+    if (form->focusedIndex >= 0) {
+        form->fields[form->focusedIndex].dirty = true;
     }
 
-    return NULL;
+    form->focusedIndex = index;
+    form->fields[index].dirty = true;
 }
 
 // Change focus to a given field
 void formFocus(Form* form, FormField* field) {
-    FormFieldListItem* listItem = fieldInList(form->fieldListHead, field);
-
-    if (listItem != NULL) {
-        form->focusedFieldItem = listItem;
+    if (field != NULL && field >= form->fields && field < form->fields + form->numFields) {
+        focusIndex(form, (int)(field - form->fields));
 
         // Changing focus resets button repeats
         formResetRepeat(form);
     }
 }
 
+// Redraw every field on the next update, such as after the screen behind the form was drawn over
+void formInvalidate(Form* form) {
+    for (int i = 0; i < form->numFields; i++) {
+        form->fields[i].dirty = true;
+    }
+}
+
 // Create field for a form
 static FormField* createField(FormFieldType type, Dimensions dimensions, const char* label, int labelFontSize, int valueFontSize, void* details) {
     FormField* field = SYS->realloc(NULL, sizeof(FormField));
@@ -128,15 +143,18 @@ static FormField* createField(FormFieldType type, Dimensions dimensions, const c
     field->labelFontSize = labelFontSize;
     field->valueFontSize = valueFontSize;
     field->details = details;
+    field->dirty = true;
+    field->hasLayout = false;
+    field->labelX = 0;
+    field->labelY = 0;
     
     return field;
 }
 
-// Destroy and deallocate a form
+// Deallocate the details of a field held by a form
 static void destroyField(FormField* field) {
-    // Dealloc field details
     SYS->realloc(field->details, 0);
-    SYS->realloc(field, 0);
+    field->details = NULL;
 }
 
 // Create a Seed field, used to set a hexadecimal-based seed for the RNG
@@ -195,23 +213,8 @@ static void seedFieldDraw(int x, int y, int width, int height, int fontSize, For
         int lineY = topY + tHeight + 2;
 
         // Now we need to find the X position where the character being edited begins.
-        // This is done by creating a substring of characters up to that character's position.
-        // Then we find the width of that substring and use it determine how far in the editing character is.
-        char previousStr[FORM_SEED_FIELD_LENGTH + 1];
-
-        // Copy characters into substring
-        int i = 0;
-        if (field->focusedIndex > 0) {
-            for (i = 0; i < field->focusedIndex; i++) {
-                previousStr[i] = field->value[i];
-            }
-        }
-
-        // Null terminate sub-string just to be on the safe side
-        previousStr[i] = '\0';
-
-        // Get drawn width of previous text
-        int precedingWidth = textWidth(previousStr, strlen(previousStr), fontSize);
+        // The width of the characters before it determines how far in the editing character is.
+        int precedingWidth = textWidth(field->value, (size_t)field->focusedIndex, fontSize);
 
         // We'll also need to get the length of just the character being editing so we know how long the line should be
         int characterWidth = textWidth(&field->value[field->focusedIndex], 1, fontSize);
@@ -225,11 +228,8 @@ static void seedFieldDraw(int x, int y, int width, int height, int fontSize, For
 // Draw Numerical field contents
 static void numericalFieldDraw(int x, int y, int width, int height, int fontSize, FormNumericalField* field) {
     // Format current number value as a string
-    char *str;
-
-    // Use PD lib to format value
-    // PD lib won't free this automatically
-    SYS->formatString(&str, "%d", *field->value);
+    char str[12];
+    snprintf(str, sizeof(str), "%d", *field->value);
 
     textDrawCentered(str, x, y, width, height, fontSize, kColorBlack);
 
@@ -243,8 +243,6 @@ static void numericalFieldDraw(int x, int y, int width, int height, int fontSize
 
         GFX->drawLine(leftX, topY + tHeight + 2, leftX + tWidth, topY + tHeight + 2, 2, kColorBlack);
     }
-
-    SYS->realloc(str, 0);
 }
 
 // Draw boolean field contents
@@ -270,8 +268,13 @@ static void formDrawField(FormField* field, bool isHighlighted) {
 
     // Draw the label above it if specified
     if (field->label != NULL) {
-        int labelHeight = textHeight(field->labelFontSize);
-        textDraw(field->label, dim->x + 3, dim->y - labelHeight - 1, field->labelFontSize, kColorWhite);
+        if (!field->hasLayout) {
+            field->labelX = dim->x + 3;
+            field->labelY = dim->y - textHeight(field->labelFontSize) - 1;
+            field->hasLayout = true;
+        }
+
+        textDraw(field->label, field->labelX, field->labelY, field->labelFontSize, kColorWhite);
     }
 
     // Draw field contents
@@ -292,25 +295,32 @@ static void formDrawField(FormField* field, bool isHighlighted) {
     }
 }
 
-// Draw all fields on a form
-static void formDrawAllFields(Form *form) {
-    if (form->fieldListHead != NULL) {
-        for (FormFieldListItem* item = form->fieldListHead; item != NULL; item = item->next) {
-            // Switch highlight every 15 frames when focused
-            bool isHighlighted = false;
-
-            if (form->focusedFieldItem == item) {
-                if (form->focusFrameCount++ == 15) {
-                    form->focusFrameCount = 0;
-                    form->focusFlipFlop = !form->focusFlipFlop;
-                }
+// Draw the fields on a form that have changed
+// Returns true if any field was drawn
+static bool formDrawDirtyFields(Form *form) {
+    bool drawn = false;
 
-                isHighlighted = !form->focusFlipFlop;
-            }
+    // Switch highlight every FOCUS_BLINK_DELAY when focused
+    if (form->focusedIndex >= 0 && form->focusFrameCount++ >= gameFramesForMs(FOCUS_BLINK_DELAY)) {
+        form->focusFrameCount = 0;
+        form->focusFlipFlop = !form->focusFlipFlop;
+        form->fields[form->focusedIndex].dirty = true;
+    }
+
+    for (int i = 0; i < form->numFields; i++) {
+        FormField* field = &form->fields[i];
+
+        if (field->dirty) {
+            bool isHighlighted = i == form->focusedIndex && !form->focusFlipFlop;
 
-            formDrawField(item->field, isHighlighted);
+            formDrawField(field, isHighlighted);
+
+            field->dirty = false;
+            drawn = true;
         }
     }
+
+    return drawn;
 }
 
 // Handle buttons on Seed field
@@ -323,12 +333,17 @@ static bool seedFieldHandleButtons(FormField* field, PDButtons buttons) {
 
         // Reset edit index
         seedField->focusedIndex = 0;
+        field->dirty = true;
 
         // Always suppress button presses for parent when switching editing modes
         return false;
     }
 
     if (seedField->isEditing) {
+        if ((buttons & (kButtonUp | kButtonRight | kButtonDown | kButtonLeft)) > 0) {
+            field->dirty = true;
+        }
+
         // Adjust which character is being editing using left and right buttons
         if ((buttons & kButtonRight) == kButtonRight) {
             if (++seedField->focusedIndex >= FORM_SEED_FIELD_LENGTH) {
@@ -378,6 +393,7 @@ static bool numericalFieldHandleButtons(FormField* field, PDButtons buttons) {
     // Pressing A will toggle editing mode
     if ((buttons & kButtonA) == kButtonA) {
         numericalField->isEditing = !numericalField->isEditing;
+        field->dirty = true;
 
         return false;
     // Increment value when Up is pressed and in editing mode
@@ -385,11 +401,15 @@ static bool numericalFieldHandleButtons(FormField* field, PDButtons buttons) {
         if (++*numericalField->value > numericalField->maxValue) {
             *numericalField->value = numericalField->minValue;
         }
+
+        field->dirty = true;
     // Decrement value when Down is pressed and in editing mode
     } else if (numericalField->isEditing && ((buttons & kButtonDown) == kButtonDown)) {
         if (--*numericalField->value < numericalField->minValue) {
             *numericalField->value = numericalField->maxValue;
         }
+
+        field->dirty = true;
     }
 
     // Don't allow parent to handle button presses if in editing mode
@@ -402,6 +422,7 @@ static bool booleanFieldHandleButtons(FormField* field, PDButtons buttons) {
      if ((buttons & kButtonA) == kButtonA) {
         FormBooleanField* booleanField = (FormBooleanField*)field->details;
         *booleanField->value = !(*booleanField->value);
+        field->dirty = true;
 
         return false;
      }
@@ -415,23 +436,28 @@ static PDButtons formGetRepeatedButtons(Form* form, PDButtons currentButtons) {
     currentButtons &= (kButtonUp | kButtonRight | kButtonDown | kButtonLeft);
     PDButtons repeatButtons = 0;
 
+    unsigned int now = SYS->getCurrentTimeMilliseconds();
+
     // If currently pressed buttons are different than the last ones, reset the counter
     if (form->btnRepeat.buttons != currentButtons) {
         formResetRepeat(form);
+        form->btnRepeat.startedMs = now;
     }
 
     form->btnRepeat.buttons = currentButtons;
 
     if (currentButtons > 0) {
-        form->btnRepeat.frames++;
+        unsigned int elapsed = now - form->btnRepeat.startedMs;
 
-        if (!form->btnRepeat.isCharged && form->btnRepeat.frames == BUTTON_CHARGE_DELAY) {
+        // Delays are counted from when the last one ended rather than from the frame it was noticed on,
+        // so repeats keep an even pace when the refresh rate doesn't divide them
+        if (!form->btnRepeat.isCharged && elapsed >= BUTTON_CHARGE_DELAY) {
             form->btnRepeat.isCharged = true;
-            form->btnRepeat.frames = 0;
-        } else if (form->btnRepeat.isCharged && form->btnRepeat.frames == BUTTON_REPEAT_DELAY) {
+            form->btnRepeat.startedMs += BUTTON_CHARGE_DELAY;
+        } else if (form->btnRepeat.isCharged && elapsed >= BUTTON_REPEAT_DELAY) {
             repeatButtons = currentButtons;
 
-            form->btnRepeat.frames = 0;
+            form->btnRepeat.startedMs += BUTTON_REPEAT_DELAY;
         }
     }
 
@@ -454,7 +480,7 @@ static bool buttonFieldHandleButtons(FormField* field, PDButtons buttons) {
 // Handle button presses on a field
 static bool formHandleButtons(Form* form, PDButtons pressed, PDButtons current) {
     bool bubble = true;
-    FormField* field = form->focusedFieldItem->field;
+    FormField* field = &form->fields[form->focusedIndex];
 
     PDButtons buttons = pressed | formGetRepeatedButtons(form, current);
 
@@ -478,17 +504,8 @@ static bool formHandleButtons(Form* form, PDButtons pressed, PDButtons current)
 
 // Blurs the currently focused field and focuses the previous one in the list
 static void focusPreviousField(Form* form) {
-    if (form->focusedFieldItem != NULL) {
-        FormFieldListItem* toFocus = form->fieldListHead;
-
-        for (FormFieldListItem* current = form->fieldListHead; current != NULL; current = current->next) {
-            if (current->next == form->focusedFieldItem) {
-                toFocus = current;
-                break;
-            }
-        }
-
-        form->focusedFieldItem = toFocus;
+    if (form->focusedIndex >= 0) {
+        focusIndex(form, form->focusedIndex > 0 ? form->focusedIndex - 1 : 0);
 
         // Reset highlight counter
         form->focusFlipFlop = false;
@@ -498,16 +515,8 @@ static void focusPreviousField(Form* form) {
 
 // Blurs the currently focused field and focuses the next one in the list
 static void focusNextField(Form* form) {
-    if (form->focusedFieldItem != NULL) {
-        FormFieldListItem* toFocus = form->focusedFieldItem;
-
-        if (form->focusedFieldItem->next != NULL) {
-            toFocus = form->focusedFieldItem->next;
-        } else {
-            toFocus = form->fieldListTail;
-        }
-
-        form->focusedFieldItem = toFocus;
+    if (form->focusedIndex >= 0) {
+        focusIndex(form, form->focusedIndex < form->numFields - 1 ? form->focusedIndex + 1 : form->numFields - 1);
 
         // Reset highlight counter
         form->focusFlipFlop = false;
@@ -515,8 +524,9 @@ static void focusNextField(Form* form) {
     }
 }
 
-// Update/draw a form. Should be called every frame
-void formUpdate(Form *form) {
+// Update form and draw fields that have changed. Should be called every frame
+// Returns true if anything was drawn
+bool formUpdate(Form *form) {
     PDButtons current;
     PDButtons pressed;
 
@@ -527,7 +537,7 @@ void formUpdate(Form *form) {
     bool allowButtonPresses = false;
 
     // Send button presses to the focused field
-    if (form->focusedFieldItem != NULL) {
+    if (form->focusedIndex >= 0) {
         allowButtonPresses = formHandleButtons(form, pressed, current);
     }
 
@@ -541,22 +551,14 @@ void formUpdate(Form *form) {
         }
     }
 
-    formDrawAllFields(form);
+    return formDrawDirtyFields(form);
 }
 
 // Destroy and deallocate a form
 void formDestroy(Form* form) {
     // Dealloc all fields
-    if (form->fieldListHead != NULL) {
-        FormFieldListItem* next = form->fieldListHead;
-
-        while (next != NULL) {
-            FormFieldListItem* tmp = next;
-            next = tmp->next;
-            destroyField(tmp->field);
-
-            SYS->realloc(tmp, 0);
-        }
+    for (int i = 0; i < form->numFields; i++) {
+        destroyField(&form->fields[i]);
     }
 
     // Dealloc the form itself
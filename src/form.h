@@ -6,6 +6,9 @@
 // Length of characters of a Seed field (WITHOUT NULL)
 #define FORM_SEED_FIELD_LENGTH 8
 
+// Most fields a form can hold
+#define FORM_MAX_FIELDS 8
+
 typedef enum FormFieldType {
     kSeed,
     kNumerical,
@@ -31,13 +34,15 @@ typedef struct FormField {
 
     // Holds data specific to the field type
     void* details;
-} FormField;
 
-typedef struct FormFieldListItem {
-    FormField* field;
-    struct FormFieldListItem* next;
-} FormFieldListItem;
+    // Set when the field has changed and needs to be drawn on the next update
+    bool dirty;
 
+    // Position of the label, worked out the first time the field is drawn
+    bool hasLayout;
+    int labelX;
+    int labelY;
+} FormField;
 
 // Houses the state of buttons held for button repeats
 typedef struct ButtonRepeatState {
@@ -47,14 +52,17 @@ typedef struct ButtonRepeatState {
     // Whether the button has been pressed long enough to start repeating
     bool isCharged;
 
-    // Current frame count 
-    int frames;
+    // Time in milliseconds the buttons were first held, moved forward each time the charge or a repeat delay passes
+    unsigned int startedMs;
 } ButtonRepeatState;
 
 typedef struct Form {
-    FormFieldListItem* fieldListHead;
-    FormFieldListItem* fieldListTail;
-    FormFieldListItem* focusedFieldItem;
+    // Fields in focus order
+    FormField fields[FORM_MAX_FIELDS];
+    int numFields;
+
+    // Index of the focused field, or -1 if the form has no fields
+    int focusedIndex;
 
     ButtonRepeatState btnRepeat;
 
@@ -79,14 +87,19 @@ typedef void (*FormButtonFieldHandler)(void* data);
 // Create a Button field, which will call the handler function when pressed
 FormField* formCreateButtonField(Dimensions dimensions, const char* value, int labelFontSize, int valueFontSize, void* data, FormButtonFieldHandler handler);
 
-// Add a field to a form
-void formAddField(Form* form, FormField* field);
+// Add a field to a form. The form takes a copy of the field and frees the one given
+// Returns the field held by the form, or NULL if the form is full
+FormField* formAddField(Form* form, FormField* field);
 
 // Change focus to a given field
 void formFocus(Form* form, FormField* field);
 
-// Update/draw form. Should be called every frame
-void formUpdate(Form* form);
+// Update form and draw fields that have changed. Should be called every frame
+// Returns true if anything was drawn
+bool formUpdate(Form* form);
+
+// Redraw every field on the next update, such as after the screen behind the form was drawn over
+void formInvalidate(Form* form);
 
 // Destroy and deallocate a form
 void formDestroy(Form* form);
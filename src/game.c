@@ -2,17 +2,40 @@
 #include "scene.h"
 #include "scenes/title/titleScene.h"
 #include "global.h"
+#include "text.h"
 #include "pd_api.h"
 
 typedef enum {
     Running,
-    SceneTransition
+    Prefetching,
+    SceneTransition,
+    ScenePush,
+    ScenePop
 } RunStatus;
 
 typedef struct {
     RunStatus status;
     Scene* currentScene;
     Scene* nextScene;
+
+    // Whether the next scene is pushed over the current scene rather than replacing it
+    bool pushNext;
+
+    // Scenes suspended under the current scene, bottom first, and the memory each holds
+    Scene* suspendedScenes[SCENE_STACK_DEPTH];
+    size_t suspendedBytes[SCENE_STACK_DEPTH];
+    int numSuspended;
+
+    // Set while the system menu is open or the device is locked. Scenes aren't updated until both are cleared
+    bool paused;
+    bool locked;
+
+    // Display refresh rate currently set
+    int refreshRate;
+
+    // Frames run and how many of them left the display as it was
+    unsigned int frames;
+    unsigned int skippedFrames;
 } GameState;
 
 // Global variable exposed in global.h
@@ -20,6 +43,12 @@ PlaydateAPI* pd = NULL;
 
 // Private function prototypes
 static int gameUpdate(void*);
+static void destroyScene(Scene* scene);
+static void startScene(Scene* scene);
+static size_t suspendedBytesTotal(void);
+
+// Frames between logging how many frames were skipped, when built with DRAW_STATS
+#define SKIPPED_FRAMES_LOG_INTERVAL (FPS * 10)
 
 // Private variables
 static GameState* gameState = NULL;
@@ -29,61 +58,282 @@ void gameInit(PlaydateAPI* playdate) {
     // Initialize global Playdate variable
     pd = playdate;
 
+    // Initial game state structure
+    gameState = SYS->realloc(NULL, sizeof(GameState));
+    gameState->refreshRate = 0;
+
     // Setup game loop
-    pd->display->setRefreshRate(FPS);
+    gameSetRefreshRate(FPS);
     SYS->setUpdateCallback(gameUpdate, NULL);
 
-    // Initial game state structure
-    gameState = SYS->realloc(NULL, sizeof(GameState));
     gameState->status = SceneTransition;
     gameState->currentScene = NULL;
     gameState->nextScene = titleSceneCreate();
+    gameState->pushNext = false;
+    gameState->numSuspended = 0;
+    gameState->paused = false;
+    gameState->locked = false;
+    gameState->frames = 0;
+    gameState->skippedFrames = 0;
 }
 
 // Main game loop called on each frame
 static int gameUpdate(void* userdata) {
     (void)userdata;
 
+    // Nothing runs or draws while the system menu is open or the device is locked
+    if (gameState->paused || gameState->locked) {
+        return 0;
+    }
+
+    // Scene transitions always redraw the screen
+    bool screenUpdated = true;
+
     switch (gameState->status) {
         case Running:
-            gameState->currentScene->update(gameState->currentScene);
+            screenUpdated = gameState->currentScene->update(gameState->currentScene);
+            break;
+
+        case Prefetching:
+            // Keep the current scene running while the next one loads a little each frame
+            screenUpdated = gameState->currentScene->update(gameState->currentScene);
+
+            if (gameState->nextScene->prefetch(gameState->nextScene)) {
+                gameState->status = gameState->pushNext ? ScenePush : SceneTransition;
+            }
             break;
 
         case SceneTransition:
-            // Dispose of previous scene (if it exists)
-            // It's assumed the destroy callback will dipose of the Scene struct
-            if (gameState->currentScene != NULL) {
-                SYS->logToConsole("Destroying scene '%s'", gameState->currentScene->name);
+            // Dispose of previous scene (if it exists) along with any it was pushed over
+            destroyScene(gameState->currentScene);
 
-                gameState->currentScene->destroy(gameState->currentScene);
+            while (gameState->numSuspended > 0) {
+                destroyScene(gameState->suspendedScenes[--gameState->numSuspended]);
             }
 
             // Move pending scene to current scene and call its initializer
-            if (gameState->nextScene != NULL) {
-                SYS->logToConsole("Switching to scene '%s'", gameState->nextScene->name);
+            startScene(gameState->nextScene);
+            break;
 
-                gameState->currentScene = gameState->nextScene;
-                gameState->nextScene = NULL;
+        case ScenePush: {
+            // Keep the current scene as it is under the new one
+            Scene* suspended = gameState->currentScene;
+            size_t bytes = suspended->footprint != NULL ? suspended->footprint(suspended) : 0;
 
-                gameState->currentScene->init(gameState->currentScene);
+            if (suspended->suspend != NULL) {
+                suspended->suspend(suspended);
             }
 
+            gameState->suspendedScenes[gameState->numSuspended] = suspended;
+            gameState->suspendedBytes[gameState->numSuspended] = bytes;
+            gameState->numSuspended++;
+
+            SYS->logToConsole("Suspended scene '%s' holding %u bytes (%u bytes in %d suspended scenes)", suspended->name, (unsigned int)bytes, (unsigned int)suspendedBytesTotal(), gameState->numSuspended);
+
+            startScene(gameState->nextScene);
+            break;
+        }
+
+        case ScenePop:
+            destroyScene(gameState->currentScene);
+
+            // Return to the scene under it
+            gameState->currentScene = gameState->suspendedScenes[--gameState->numSuspended];
             gameState->status = Running;
+
+            SYS->logToConsole("Resuming scene '%s' (%u bytes in %d suspended scenes)", gameState->currentScene->name, (unsigned int)suspendedBytesTotal(), gameState->numSuspended);
+
+            gameSetRefreshRate(gameState->currentScene->refreshRate);
+
+            if (gameState->currentScene->resume != NULL) {
+                gameState->currentScene->resume(gameState->currentScene);
+            }
             break;
     }
 
-    return 1;
+    gameState->frames++;
+
+    if (!screenUpdated) {
+        gameState->skippedFrames++;
+    }
+
+#ifdef DRAW_STATS
+    if (gameState->frames == SKIPPED_FRAMES_LOG_INTERVAL) {
+        SYS->logToConsole("Skipped display updates on %u of %u frames", gameState->skippedFrames, gameState->frames);
+
+        gameState->frames = 0;
+        gameState->skippedFrames = 0;
+    }
+#endif
+
+    // Returning 0 tells the system nothing was drawn, so the display isn't updated
+    return screenUpdated ? 1 : 0;
 }
 
-// Transition to a new scene. Current scene will be terminated and the new one will be displayed on next frame. 
+// Handle a system event other than initialization
+void gameHandleEvent(PDSystemEvent event) {
+    if (gameState == NULL) {
+        return;
+    }
+
+    switch (event) {
+        case kEventPause:
+            gameState->paused = true;
+            break;
+
+        case kEventResume:
+            gameState->paused = false;
+            break;
+
+        case kEventLock:
+            gameState->locked = true;
+            break;
+
+        case kEventUnlock:
+            gameState->locked = false;
+            break;
+
+        case kEventLowPower:
+            // Rendered strings are redrawn as they're needed
+            textCacheClear();
+            break;
+
+        case kEventTerminate:
+            break;
+
+        default:
+            // Key events are only sent to Lua
+            return;
+    }
+
+    Scene* scene = gameState->currentScene;
+
+    if (scene != NULL && scene->handleEvent != NULL) {
+        scene->handleEvent(scene, event);
+    }
+
+    // Scenes may hold files open, such as the board's replay
+    if (event == kEventTerminate) {
+        // Suspended scenes are told too, as they're destroyed along with the active scene
+        for (int i = 0; i < gameState->numSuspended; i++) {
+            scene = gameState->suspendedScenes[i];
+
+            if (scene->handleEvent != NULL) {
+                scene->handleEvent(scene, event);
+            }
+        }
+
+        destroyScene(gameState->currentScene);
+        gameState->currentScene = NULL;
+
+        while (gameState->numSuspended > 0) {
+            destroyScene(gameState->suspendedScenes[--gameState->numSuspended]);
+        }
+    }
+}
+
+// Change the display refresh rate, if it isn't already at the given rate
+void gameSetRefreshRate(int rate) {
+    if (rate > 0 && rate != gameState->refreshRate) {
+        pd->display->setRefreshRate((float)rate);
+        gameState->refreshRate = rate;
+    }
+}
+
+// Current display refresh rate
+int gameRefreshRate(void) {
+    return gameState->refreshRate;
+}
+
+// Number of frames at the current refresh rate that last for the given number of milliseconds, at least 1
+int gameFramesForMs(int ms) {
+    int frames = (ms * gameState->refreshRate) / 1000;
+
+    return frames > 0 ? frames : 1;
+}
+
+// Dispose of a scene, if it exists
+// It's assumed the destroy callback will dipose of the Scene struct
+static void destroyScene(Scene* scene) {
+    if (scene != NULL) {
+        SYS->logToConsole("Destroying scene '%s'", scene->name);
+
+        scene->destroy(scene);
+    }
+}
+
+// Make a pending scene the current scene and call its initializer
+static void startScene(Scene* scene) {
+    if (scene != NULL) {
+        SYS->logToConsole("Switching to scene '%s'", scene->name);
+
+        gameState->currentScene = scene;
+        gameState->nextScene = NULL;
+
+        gameSetRefreshRate(scene->refreshRate);
+
+        scene->init(scene);
+    }
+
+    gameState->status = Running;
+}
+
+// Memory held by every suspended scene
+static size_t suspendedBytesTotal(void) {
+    size_t total = 0;
+
+    for (int i = 0; i < gameState->numSuspended; i++) {
+        total += gameState->suspendedBytes[i];
+    }
+
+    return total;
+}
+
+// Transition to a new scene. The new scene prefetches its assets while the current one keeps running,
+// then the current scene is terminated and the new one is displayed on the following frame.
 void gameChangeScene(Scene* scene) {
     // Do not allow a scene change if one is already in progress
-    if (gameState->status != SceneTransition) {
+    if (gameState->status == Running) {
         SYS->logToConsole("Received transition request to scene '%s'", scene->name);
 
         gameState->nextScene = scene;
-        gameState->status = SceneTransition;
+        gameState->pushNext = false;
+        gameState->status = scene->prefetch != NULL ? Prefetching : SceneTransition;
+    } else {
+        SYS->logToConsole("Attempted to transition to new scene '%s' while already in a transition.", scene->name);
+    }
+}
+
+// Returns whether a scene can be pushed right now
+bool gameCanPushScene(void) {
+    return gameState->status == Running && gameState->numSuspended < SCENE_STACK_DEPTH;
+}
+
+// Suspend the current scene and show a new one over it. The new scene prefetches its assets first,
+// like with gameChangeScene, and the current scene is resumed once the new one is popped.
+bool gamePushScene(Scene* scene) {
+    if (gameCanPushScene()) {
+        SYS->logToConsole("Received push request for scene '%s'", scene->name);
+
+        gameState->nextScene = scene;
+        gameState->pushNext = true;
+        gameState->status = scene->prefetch != NULL ? Prefetching : ScenePush;
+
+        return true;
+    }
+
+    SYS->logToConsole("Unable to push scene '%s' while in a transition or with %d scenes suspended.", scene->name, gameState->numSuspended);
+
+    return false;
+}
+
+// Terminate the current scene and resume the scene it was pushed over on the next frame
+void gamePopScene(void) {
+    if (gameState->status == Running && gameState->numSuspended > 0) {
+        SYS->logToConsole("Received pop request for scene '%s'", gameState->currentScene->name);
+
+        gameState->status = ScenePop;
     } else {
-        SYS->logToConsole("Attempted to transition to new scene '%s' while already in a transition.");
+        SYS->logToConsole("Unable to pop scene while in a transition or with no scene suspended.");
     }
 }
\ No newline at end of file
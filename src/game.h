@@ -3,10 +3,36 @@
 
 #include "scene.h"
 
+// Most scenes that can be suspended under the current scene
+#define SCENE_STACK_DEPTH 4
+
 // Initializes game state and loop
 void gameInit(PlaydateAPI* pd);
 
+// Handle a system event other than initialization, passing lifecycle events on to the active scene
+void gameHandleEvent(PDSystemEvent event);
+
+// Change the display refresh rate, if it isn't already at the given rate
+void gameSetRefreshRate(int rate);
+
+// Current display refresh rate
+int gameRefreshRate(void);
+
+// Number of frames at the current refresh rate that last for the given number of milliseconds, at least 1
+int gameFramesForMs(int ms);
+
 // Transition to a new scene. Current scene will be terminated and the new one will be displayed on next frame.
+// Any suspended scenes are terminated as well.
 void gameChangeScene(Scene* scene);
 
+// Returns whether a scene can be pushed right now, so callers can avoid creating one that would be rejected
+bool gameCanPushScene(void);
+
+// Suspend the current scene and show a new one over it on the next frame. The suspended scene keeps its state.
+// Returns false if the push was rejected, in which case the caller still owns the scene.
+bool gamePushScene(Scene* scene);
+
+// Terminate the current scene and resume the scene it was pushed over on the next frame.
+void gamePopScene(void);
+
 #endif
\ No newline at end of file
@@ -6,6 +6,10 @@
 // Use 50 FPS as our goal, which is the max the Playdate can do
 #define FPS 50
 
+// Lower refresh rates for screens that only change in response to input
+#define MENU_FPS 20
+#define IDLE_FPS 10
+
 // Global variable to expose Playdate API
 extern PlaydateAPI* pd;
 
@@ -11,11 +11,13 @@ __declspec(dllexport)
 int eventHandler(PlaydateAPI* pd, PDSystemEvent event, uint32_t arg) {
 	(void)arg;
 
-	// For C API the only thing we need to listen for is initialization.
 	// Calling setUpdateCallback disconnects the LUA engine and gives us our update function full control
 	if (event == kEventInit) {
 		// gameInit is responsible for setting up the game loop
 		gameInit(pd);
+	} else {
+		// Pause, lock, low power and terminate are passed on to the active scene
+		gameHandleEvent(event);
 	}
 	
 	return 0;
@@ -5,8 +5,12 @@ void rand_seed(unsigned int s) {
     seed = s;
 }
 
+unsigned int rand_advance(unsigned int state) {
+    return ((1103515245 * state) + 12345) % 2147483648;
+}
+
 unsigned int rand_next() {
-    seed = ((1103515245 * seed) + 12345) % 2147483648;
+    seed = rand_advance(seed);
 
     return seed;
 }
\ No newline at end of file
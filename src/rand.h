@@ -3,6 +3,10 @@
 
 void rand_seed(unsigned int seed);
 
+// Returns the state following the given one
+// Lets callers that keep their own RNG state (e.g. host tools) produce the same sequence as rand_next
+unsigned int rand_advance(unsigned int state);
+
 unsigned int rand_next();
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "pd_api.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct Scene {
     // Name of scene
@@ -13,6 +14,10 @@ typedef struct Scene {
     // Always triggers a screen redraw.
     void (*init)(struct Scene* scene);
 
+    // Called on each frame while the previous scene is still running, before init. Does a small amount of
+    // loading and returns true once the scene is ready to start. May be NULL if the scene has nothing to load
+    bool (*prefetch)(struct Scene* scene);
+
     // Called on each frame of active scene. Return value is whether or not the screen should redraw.
     bool (*update)(struct Scene* scene);
 
@@ -20,6 +25,24 @@ typedef struct Scene {
     // Always triggers a screen redraw after next scene takes over.
     void (*destroy)(struct Scene* scene);
 
+    // Called when another scene is pushed over this one. The scene keeps its state until it's resumed or destroyed.
+    // May be NULL
+    void (*suspend)(struct Scene* scene);
+
+    // Called when the scene pushed over this one is popped. Should redraw the screen
+    // May be NULL, in which case the screen is left as the popped scene left it
+    void (*resume)(struct Scene* scene);
+
+    // Called for the pause, resume, lock, unlock, low power and terminate system events while the scene is active.
+    // The scene isn't updated while the game is paused or locked. May be NULL
+    void (*handleEvent)(struct Scene* scene, PDSystemEvent event);
+
+    // Approximate bytes of memory the scene holds on to while suspended. May be NULL
+    size_t (*footprint)(struct Scene* scene);
+
+    // Display refresh rate set when the scene becomes active
+    int refreshRate;
+
     // Scene state
     void* data;
 } Scene;
@@ -1,30 +1,73 @@
 #include "assets.h"
 #include "../../asset.h"
 #include "global.h"
+#include <stddef.h>
+
+// Where each bitmap asset is loaded from and stored
+typedef struct BitmapAssetPath {
+    size_t offset;
+    const char* path;
+} BitmapAssetPath;
+
+static const BitmapAssetPath bitmapAssetPaths[BOARD_BITMAP_ASSET_COUNT] = {
+    { offsetof(BoardSceneBitmapAssets, background), "images/background.png" },
+    { offsetof(BoardSceneBitmapAssets, column), "images/column.png" },
+    { offsetof(BoardSceneBitmapAssets, blockChessboard), "images/blocks/chessboard.png" },
+    { offsetof(BoardSceneBitmapAssets, blockEye), "images/blocks/eye.png" },
+    { offsetof(BoardSceneBitmapAssets, blockBox), "images/blocks/box.png" },
+    { offsetof(BoardSceneBitmapAssets, blockTargetClosed), "images/blocks/target-closed.png" },
+    { offsetof(BoardSceneBitmapAssets, blockTargetOpen), "images/blocks/target-open.png" },
+    { offsetof(BoardSceneBitmapAssets, blockTracks), "images/blocks/tracks.png" },
+    { offsetof(BoardSceneBitmapAssets, blockTracksReversed), "images/blocks/tracks-reversed.png" },
+    { offsetof(BoardSceneBitmapAssets, gameOverOne), "images/game-over/1.png" },
+    { offsetof(BoardSceneBitmapAssets, gameOverTwo), "images/game-over/2.png" },
+    { offsetof(BoardSceneBitmapAssets, gameOverThree), "images/game-over/3.png" },
+    { offsetof(BoardSceneBitmapAssets, gameOverFour), "images/game-over/4.png" }
+};
 
 // Load bitmap assets
 BoardSceneBitmapAssets* loadBitmapAssets() {
+    BoardSceneBitmapAssets* assets = createBitmapAssets();
+
+    if (assets != NULL) {
+        for (int i = 0; i < BOARD_BITMAP_ASSET_COUNT; i++) {
+            loadBitmapAsset(assets, i);
+        }
+    }
+
+    return assets;
+}
+
+// Create bitmap assets without loading any of them
+BoardSceneBitmapAssets* createBitmapAssets() {
     BoardSceneBitmapAssets* assets = SYS->realloc(NULL, sizeof(BoardSceneBitmapAssets));
 
     if (assets != NULL) {
-        assets->background = assetLoadBitmap("images/background.png");
-        assets->column = assetLoadBitmap("images/column.png");
-        assets->blockChessboard = assetLoadBitmap("images/blocks/chessboard.png");
-        assets->blockEye = assetLoadBitmap("images/blocks/eye.png");
-        assets->blockBox = assetLoadBitmap("images/blocks/box.png");
-        assets->blockTargetClosed = assetLoadBitmap("images/blocks/target-closed.png");
-        assets->blockTargetOpen = assetLoadBitmap("images/blocks/target-open.png");
-        assets->blockTracks = assetLoadBitmap("images/blocks/tracks.png");
-        assets->blockTracksReversed = assetLoadBitmap("images/blocks/tracks-reversed.png");
-        assets->gameOverOne = assetLoadBitmap("images/game-over/1.png");
-        assets->gameOverTwo = assetLoadBitmap("images/game-over/2.png");
-        assets->gameOverThree = assetLoadBitmap("images/game-over/3.png");
-        assets->gameOverFour = assetLoadBitmap("images/game-over/4.png");
+        for (int i = 0; i < BOARD_BITMAP_ASSET_COUNT; i++) {
+            *(LCDBitmap**)((uint8_t*)assets + bitmapAssetPaths[i].offset) = NULL;
+        }
     }
 
     return assets;
 }
 
+// Load one bitmap asset if it isn't loaded yet
+bool loadBitmapAsset(BoardSceneBitmapAssets* assets, int index) {
+    if (index < 0 || index >= BOARD_BITMAP_ASSET_COUNT) {
+        return false;
+    }
+
+    LCDBitmap** bitmap = (LCDBitmap**)((uint8_t*)assets + bitmapAssetPaths[index].offset);
+
+    if (*bitmap != NULL) {
+        return false;
+    }
+
+    *bitmap = assetLoadBitmap(bitmapAssetPaths[index].path);
+
+    return true;
+}
+
 // Load audio sample assets
 BoardSceneSampleAssets* loadSampleAssets() {
     BoardSceneSampleAssets* assets = SYS->realloc(NULL, sizeof(BoardSceneSampleAssets));
@@ -36,4 +79,30 @@ BoardSceneSampleAssets* loadSampleAssets() {
     }
 
     return assets;
+}
+
+// Free bitmap assets
+void freeBitmapAssets(BoardSceneBitmapAssets* assets) {
+    for (int i = 0; i < BOARD_BITMAP_ASSET_COUNT; i++) {
+        LCDBitmap* bitmap = *(LCDBitmap**)((uint8_t*)assets + bitmapAssetPaths[i].offset);
+
+        if (bitmap != NULL) {
+            GFX->freeBitmap(bitmap);
+        }
+    }
+
+    SYS->realloc(assets, 0);
+}
+
+// Free audio sample assets
+void freeSampleAssets(BoardSceneSampleAssets* assets) {
+    AudioSample* samples[] = { assets->kick, assets->perc, assets->whoop };
+
+    for (int i = 0; i < 3; i++) {
+        if (samples[i] != NULL) {
+            SND->sample->freeSample(samples[i]);
+        }
+    }
+
+    SYS->realloc(assets, 0);
 }
\ No newline at end of file
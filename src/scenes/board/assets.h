@@ -2,6 +2,7 @@
 #define SCENES_BOARD_ASSETS_H
 
 #include "pd_api.h"
+#include <stdbool.h>
 
 typedef struct BoardSceneBitmapAssets {
     // Background image
@@ -26,6 +27,9 @@ typedef struct BoardSceneBitmapAssets {
     LCDBitmap* gameOverFour;
 } BoardSceneBitmapAssets;
 
+// Number of bitmaps in BoardSceneBitmapAssets
+#define BOARD_BITMAP_ASSET_COUNT 13
+
 typedef struct BoardSceneSampleAssets {
     // Whoop used for piece rotation
     AudioSample* whoop;
@@ -40,7 +44,20 @@ typedef struct BoardSceneSampleAssets {
 // Load all bitmap assets for board scene
 BoardSceneBitmapAssets* loadBitmapAssets(void);
 
+// Create bitmap assets for board scene with nothing loaded yet
+BoardSceneBitmapAssets* createBitmapAssets(void);
+
+// Load a single bitmap asset, [0, BOARD_BITMAP_ASSET_COUNT), if it isn't loaded yet
+// Returns false if it was already loaded
+bool loadBitmapAsset(BoardSceneBitmapAssets* assets, int index);
+
 // Load all audio sample assets for board scene
 BoardSceneSampleAssets* loadSampleAssets(void);
 
+// Free bitmap assets and the struct holding them
+void freeBitmapAssets(BoardSceneBitmapAssets* assets);
+
+// Free audio sample assets and the struct holding them
+void freeSampleAssets(BoardSceneSampleAssets* assets);
+
 #endif
\ No newline at end of file
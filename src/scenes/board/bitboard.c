@@ -0,0 +1,358 @@
+#include "bitboard.h"
+
+// Constants used to work on 4 rows at once, with each row in its own 16-bit lane of a 64-bit word
+#define LANE_ONES 0x0001000100010001ULL
+#define LANE_LOW_BITS 0x7FFF7FFF7FFF7FFFULL
+#define LANE_HIGH_BIT 0x8000800080008000ULL
+
+// Cells of a piece in one orientation
+typedef struct BitboardShape {
+    // Rows of the piece packed into 16-bit lanes, starting at the piece's top-most filled row
+    // Column bits are relative to the piece position
+    uint64_t lanes;
+
+    // Bounds of the filled cells relative to the piece position
+    int minCol;
+    int maxCol;
+    int minRow;
+    int maxRow;
+
+    // Lowest filled row in each column from minCol, relative to the piece position. -1 for empty columns
+    int8_t bottoms[4];
+} BitboardShape;
+
+static BitboardShape SHAPES[7][4];
+
+static bool initialized = false;
+
+// Read 4 consecutive rows into the lanes of a 64-bit word
+static inline uint64_t loadRows(const BitboardRow* rows) {
+    return (uint64_t)rows[0]
+        | ((uint64_t)rows[1] << 16)
+        | ((uint64_t)rows[2] << 32)
+        | ((uint64_t)rows[3] << 48);
+}
+
+// Move a shape's lanes to the given column
+// Bounds must have been checked first so no bits cross into a neighbouring lane
+static inline uint64_t placeLanes(const BitboardShape* shape, int col) {
+    return col >= 0
+        ? shape->lanes << col
+        : shape->lanes >> -col;
+}
+
+// Build the piece shape tables from the matrix piece definitions. Must be called once before use
+void bitboardInit(void) {
+    if (initialized) {
+        return;
+    }
+
+    for (int piece = O; piece <= J; piece++) {
+        for (int orientation = 0; orientation < 4; orientation++) {
+            BitboardShape* shape = &SHAPES[piece][orientation];
+            MatrixPiecePoints points = matrixGetPointsForPiece((Piece)piece, 0, 0, orientation);
+
+            shape->minCol = MATRIX_GRID_COLS;
+            shape->maxCol = 0;
+            shape->minRow = MATRIX_GRID_ROWS;
+            shape->maxRow = 0;
+
+            for (int i = 0; i < points.numPoints; i++) {
+                const int* point = points.points[i];
+
+                if (point[0] < shape->minCol) {
+                    shape->minCol = point[0];
+                }
+
+                if (point[0] > shape->maxCol) {
+                    shape->maxCol = point[0];
+                }
+
+                if (point[1] < shape->minRow) {
+                    shape->minRow = point[1];
+                }
+
+                if (point[1] > shape->maxRow) {
+                    shape->maxRow = point[1];
+                }
+            }
+
+            shape->lanes = 0;
+
+            for (int i = 0; i < 4; i++) {
+                shape->bottoms[i] = -1;
+            }
+
+            for (int i = 0; i < points.numPoints; i++) {
+                const int* point = points.points[i];
+
+                shape->lanes |= (1ULL << point[0]) << ((point[1] - shape->minRow) * 16);
+
+                if (point[1] > shape->bottoms[point[0] - shape->minCol]) {
+                    shape->bottoms[point[0] - shape->minCol] = (int8_t)point[1];
+                }
+            }
+        }
+    }
+
+    initialized = true;
+}
+
+// Clear all cells in the playfield
+void bitboardClear(Bitboard board) {
+    for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
+        board[row] = 0;
+    }
+
+    for (int row = MATRIX_GRID_ROWS; row < BITBOARD_STRIDE; row++) {
+        board[row] = BITBOARD_FULL_ROW;
+    }
+}
+
+// Returns whether all 4 cells of a piece are within the playfield and not already filled
+bool bitboardPieceFits(const Bitboard board, Piece piece, Position pos) {
+    if (piece == None) {
+        return false;
+    }
+
+    const BitboardShape* shape = &SHAPES[piece][pos.orientation];
+    const int top = pos.row + shape->minRow;
+
+    if (top < 0 || (pos.row + shape->maxRow) >= MATRIX_GRID_ROWS) {
+        return false;
+    }
+
+    if ((pos.col + shape->minCol) < 0 || (pos.col + shape->maxCol) >= MATRIX_GRID_COLS) {
+        return false;
+    }
+
+    return (loadRows(&board[top]) & placeLanes(shape, pos.col)) == 0;
+}
+
+// Returns if the given piece sits on top another piece or the floor
+// The piece must be at a position it fits in
+bool bitboardCanSettle(const Bitboard board, Piece piece, Position pos) {
+    const BitboardShape* shape = &SHAPES[piece][pos.orientation];
+
+    // Test the piece one row down. The floor rows take care of the bottom of the playfield
+    return (loadRows(&board[pos.row + shape->minRow + 1]) & placeLanes(shape, pos.col)) != 0;
+}
+
+// Determine where a piece would sit if it dropped straight down
+Position bitboardDropPosition(const Bitboard board, Piece piece, Position pos) {
+    for (int row = pos.row; row < MATRIX_GRID_ROWS; row++) {
+        pos.row = row;
+        if (bitboardCanSettle(board, piece, pos)) {
+            break;
+        }
+    }
+
+    return pos;
+}
+
+// Build the column copy of a playfield. Must be rebuilt whenever the playfield changes
+void bitboardBuildColumns(const Bitboard board, BitboardColumns columns) {
+    for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+        columns[col] = 1u << MATRIX_GRID_ROWS;
+    }
+
+    for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
+        BitboardRow cells = board[row];
+
+        while (cells != 0) {
+            int col = __builtin_ctz(cells);
+
+            columns[col] |= 1u << row;
+            cells &= cells - 1;
+        }
+    }
+}
+
+// Determine where a piece would sit if it dropped straight down, using a column copy of the playfield
+// Gives the same result as bitboardDropPosition. The piece must be at a position it fits in
+Position bitboardColumnsDropPosition(const BitboardColumns columns, Piece piece, Position pos) {
+    const BitboardShape* shape = &SHAPES[piece][pos.orientation];
+    int distance = MATRIX_GRID_ROWS;
+
+    // The piece can fall as far as the smallest gap below any of its columns
+    for (int i = 0; i <= shape->maxCol - shape->minCol; i++) {
+        if (shape->bottoms[i] < 0) {
+            continue;
+        }
+
+        int bottom = pos.row + shape->bottoms[i];
+        int gap = __builtin_ctz(columns[pos.col + shape->minCol + i] >> (bottom + 1));
+
+        if (gap < distance) {
+            distance = gap;
+        }
+    }
+
+    pos.row += distance;
+
+    return pos;
+}
+
+// Fill the cells of a piece
+void bitboardAddPiece(Bitboard board, Piece piece, Position pos) {
+    const BitboardShape* shape = &SHAPES[piece][pos.orientation];
+    const int top = pos.row + shape->minRow;
+    const uint64_t lanes = placeLanes(shape, pos.col);
+
+    for (int i = 0; i <= shape->maxRow - shape->minRow; i++) {
+        board[top + i] |= (BitboardRow)(lanes >> (i * 16));
+    }
+}
+
+// Returns a mask of completed rows (bit N is row N)
+uint32_t bitboardCompletedRows(const Bitboard board) {
+    const uint64_t full = BITBOARD_FULL_ROW * LANE_ONES;
+    uint32_t completed = 0;
+
+    // Check 4 rows at a time
+    for (int row = 0; row < MATRIX_GRID_ROWS; row += 4) {
+        uint64_t missing = loadRows(&board[row]) ^ full;
+
+        // The high bit of a lane ends up set if the lane has any missing cells
+        // The low bits are masked first so the addition can't carry into the next lane
+        uint64_t incomplete = ((missing & LANE_LOW_BITS) + LANE_LOW_BITS) | missing;
+        uint64_t complete = ~incomplete & LANE_HIGH_BIT;
+
+        uint32_t rows = (uint32_t)(((complete >> 15) & 1)
+            | ((complete >> 30) & 2)
+            | ((complete >> 45) & 4)
+            | ((complete >> 60) & 8));
+
+        completed |= rows << row;
+    }
+
+    return completed;
+}
+
+// Remove the rows in the mask, moving the rows above them down
+void bitboardRemoveRows(Bitboard board, uint32_t rowMask) {
+    int target = MATRIX_GRID_ROWS - 1;
+
+    for (int row = MATRIX_GRID_ROWS - 1; row >= 0; row--) {
+        if ((rowMask & (1u << row)) == 0) {
+            board[target--] = board[row];
+        }
+    }
+
+    // Clear the rows left at the top
+    while (target >= 0) {
+        board[target--] = 0;
+    }
+}
+
+// Push the playfield up and fill the bottom rows with garbage
+bool bitboardAddGarbageRows(Bitboard board, int numRows, int holeCol) {
+    bool fits = true;
+
+    if (numRows > MATRIX_GRID_ROWS) {
+        numRows = MATRIX_GRID_ROWS;
+    }
+
+    for (int row = 0; row < numRows; row++) {
+        if (board[row] != 0) {
+            fits = false;
+        }
+    }
+
+    for (int row = 0; row < MATRIX_GRID_ROWS - numRows; row++) {
+        board[row] = board[row + numRows];
+    }
+
+    for (int row = MATRIX_GRID_ROWS - numRows; row < MATRIX_GRID_ROWS; row++) {
+        board[row] = BITBOARD_FULL_ROW & (BitboardRow)~(1u << holeCol);
+    }
+
+    return fits;
+}
+
+// Add the cells of a row that are connected to cells already reached in the row itself or the rows either side
+// Returns whether any cells were added
+static inline bool growGrounded(const Bitboard board, Bitboard grounded, int row) {
+    BitboardRow reached = grounded[row] | (board[row] & grounded[row + 1]);
+
+    if (row > 0) {
+        reached |= board[row] & grounded[row - 1];
+    }
+
+    // Spread sideways along runs of filled cells
+    BitboardRow spread;
+
+    while ((spread = (reached | (BitboardRow)(reached << 1) | (reached >> 1)) & board[row]) != reached) {
+        reached = spread;
+    }
+
+    if (reached == grounded[row]) {
+        return false;
+    }
+
+    grounded[row] = reached;
+
+    return true;
+}
+
+// Find the filled cells connected to the floor by flood filling a row at a time, starting from the floor rows
+static void findGrounded(const Bitboard board, Bitboard grounded) {
+    for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
+        grounded[row] = 0;
+    }
+
+    for (int row = MATRIX_GRID_ROWS; row < BITBOARD_STRIDE; row++) {
+        grounded[row] = board[row];
+    }
+
+    // Paths can wind back down, so passes alternate direction until nothing more is reached
+    bool grew = true;
+
+    while (grew) {
+        grew = false;
+
+        for (int row = MATRIX_GRID_ROWS - 1; row >= 0; row--) {
+            grew |= growGrounded(board, grounded, row);
+        }
+
+        if (!grew) {
+            break;
+        }
+
+        grew = false;
+
+        for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
+            grew |= growGrounded(board, grounded, row);
+        }
+    }
+}
+
+// Move every filled cell that isn't connected to the floor down one row
+bool bitboardDropFloating(Bitboard board, Bitboard floating) {
+    Bitboard grounded;
+    BitboardRow anyFloating = 0;
+
+    findGrounded(board, grounded);
+
+    for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
+        floating[row] = board[row] & (BitboardRow)~grounded[row];
+        anyFloating |= floating[row];
+    }
+
+    for (int row = MATRIX_GRID_ROWS; row < BITBOARD_STRIDE; row++) {
+        floating[row] = 0;
+    }
+
+    if (anyFloating == 0) {
+        return false;
+    }
+
+    // A floating cell can only have an empty or another floating cell below it, so they all move at once
+    for (int row = MATRIX_GRID_ROWS - 1; row > 0; row--) {
+        board[row] = grounded[row] | floating[row - 1];
+    }
+
+    board[0] = grounded[0];
+
+    return true;
+}
\ No newline at end of file
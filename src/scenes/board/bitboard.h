@@ -0,0 +1,69 @@
+#ifndef SCENES_BOARD_BITBOARD_H
+#define SCENES_BOARD_BITBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "matrix.h"
+
+// A compact copy of the locked cells of a playfield matrix, one bit per cell.
+// Collision, settle and line checks against it give the same answers as the MatrixGrid
+// based checks in the board scene, at a fraction of the cost.
+
+// Each row of the playfield packed into the low MATRIX_GRID_COLS bits (bit N is column N)
+typedef uint16_t BitboardRow;
+
+#define BITBOARD_FULL_ROW ((BitboardRow)((1 << MATRIX_GRID_COLS) - 1))
+
+// Rows below the playfield that are always filled.
+// They act as the floor and allow any 4 rows of a piece to be read with a single 64-bit load
+#define BITBOARD_FLOOR_ROWS 4
+#define BITBOARD_STRIDE (MATRIX_GRID_ROWS + BITBOARD_FLOOR_ROWS)
+
+typedef BitboardRow Bitboard[BITBOARD_STRIDE];
+
+// Each column of the playfield packed into bits (bit N is row N), with the bit below the last row always set as the floor.
+// Gives the landing row of a piece by looking at each of its columns once rather than stepping down row by row
+typedef uint32_t BitboardColumns[MATRIX_GRID_COLS];
+
+// Build the piece shape tables from the matrix piece definitions. Must be called once before use
+void bitboardInit(void);
+
+// Clear all cells in the playfield
+void bitboardClear(Bitboard board);
+
+// Returns whether all 4 cells of a piece are within the playfield and not already filled
+bool bitboardPieceFits(const Bitboard board, Piece piece, Position pos);
+
+// Returns if the given piece sits on top another piece or the floor
+// The piece must be at a position it fits in
+bool bitboardCanSettle(const Bitboard board, Piece piece, Position pos);
+
+// Determine where a piece would sit if it dropped straight down
+Position bitboardDropPosition(const Bitboard board, Piece piece, Position pos);
+
+// Build the column copy of a playfield. Must be rebuilt whenever the playfield changes
+void bitboardBuildColumns(const Bitboard board, BitboardColumns columns);
+
+// Determine where a piece would sit if it dropped straight down, using a column copy of the playfield
+// Gives the same result as bitboardDropPosition. The piece must be at a position it fits in
+Position bitboardColumnsDropPosition(const BitboardColumns columns, Piece piece, Position pos);
+
+// Fill the cells of a piece
+void bitboardAddPiece(Bitboard board, Piece piece, Position pos);
+
+// Returns a mask of completed rows (bit N is row N)
+uint32_t bitboardCompletedRows(const Bitboard board);
+
+// Remove the rows in the mask, moving the rows above them down
+void bitboardRemoveRows(Bitboard board, uint32_t rowMask);
+
+// Push the playfield up and fill the bottom rows with garbage, leaving one empty cell in each at holeCol
+// Returns false if filled cells were pushed off the top
+bool bitboardAddGarbageRows(Bitboard board, int numRows, int holeCol);
+
+// Move every filled cell that isn't connected to the floor down one row. Cells that share a side are connected
+// floating is set to the cells that moved, in the rows they moved from
+// Returns false if nothing moved. Call until it does to let every loose group fall as far as it can
+bool bitboardDropFloating(Bitboard board, Bitboard floating);
+
+#endif
\ No newline at end of file
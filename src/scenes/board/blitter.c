@@ -0,0 +1,155 @@
+#include "blitter.h"
+#include "global.h"
+
+#define CELL_MASK ((1 << MATRIX_GRID_CELL_SIZE) - 1)
+
+// Frame buffer words hold pixels most significant bit first, so they're byte swapped on load and store
+#define LOAD_WORD(p) __builtin_bswap32(*(p))
+#define STORE_WORD(p, v) (*(p) = __builtin_bswap32(v))
+
+// Read the block patterns from the bitmaps for each piece (indexed by Piece)
+// Returns false if a bitmap can't be used, in which case the matrix should be drawn with the SDK
+bool blitterInit(Blitter* blitter, LCDBitmap* const blocks[7]) {
+    for (int piece = 0; piece < 7; piece++) {
+        int width = 0;
+        int height = 0;
+        int rowBytes = 0;
+        uint8_t* mask = NULL;
+        uint8_t* data = NULL;
+
+        if (blocks[piece] == NULL) {
+            return false;
+        }
+
+        GFX->getBitmapData(blocks[piece], &width, &height, &rowBytes, &mask, &data);
+
+        if (data == NULL || width != MATRIX_GRID_CELL_SIZE || height != MATRIX_GRID_CELL_SIZE) {
+            return false;
+        }
+
+        for (int y = 0; y < MATRIX_GRID_CELL_SIZE; y++) {
+            const uint8_t* row = &data[y * rowBytes];
+            uint16_t bits = (uint16_t)((((row[0] << 8) | row[1]) >> (16 - MATRIX_GRID_CELL_SIZE)) & CELL_MASK);
+
+            // Transparent pixels show the white of an empty cell
+            if (mask != NULL) {
+                const uint8_t* maskRow = &mask[y * rowBytes];
+                uint16_t opaque = (uint16_t)((((maskRow[0] << 8) | maskRow[1]) >> (16 - MATRIX_GRID_CELL_SIZE)) & CELL_MASK);
+
+                bits = (bits & opaque) | (~opaque & CELL_MASK);
+            }
+
+            blitter->patterns[piece][y] = bits;
+        }
+    }
+
+    // Keep whatever is drawn to the left and right of the matrix in the words it shares
+    int lastBit = BLITTER_FIRST_BIT + MATRIX_WIDTH;
+
+    for (int word = 0; word < BLITTER_WORDS; word++) {
+        uint32_t keep = 0;
+
+        for (int bit = 0; bit < 32; bit++) {
+            int x = (word * 32) + bit;
+
+            if (x < BLITTER_FIRST_BIT || x >= lastBit) {
+                keep |= 0x80000000u >> bit;
+            }
+        }
+
+        blitter->keepMask[word] = keep;
+    }
+
+    return true;
+}
+
+// Draw the locked cells of matrix rows [firstRow, lastRow]. Cells of the player piece are drawn empty
+// data is the first of the BLITTER_WORDS words of the top pixel row, rowBytes must be a multiple of 4
+void blitterDrawRows(const Blitter* blitter, const MatrixGrid matrix, int firstRow, int lastRow, uint8_t* data, int rowBytes) {
+    static const uint16_t EMPTY_CELL[MATRIX_GRID_CELL_SIZE] = {
+        CELL_MASK, CELL_MASK, CELL_MASK, CELL_MASK, CELL_MASK,
+        CELL_MASK, CELL_MASK, CELL_MASK, CELL_MASK, CELL_MASK
+    };
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        const uint16_t* cells[MATRIX_GRID_COLS];
+
+        for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+            const MatrixCell* cell = &matrix[row][col];
+
+            cells[col] = (cell->filled && !cell->player && cell->piece != None) ? blitter->patterns[cell->piece] : EMPTY_CELL;
+        }
+
+        for (int line = 0; line < MATRIX_GRID_CELL_SIZE; line++) {
+            int y = MATRIX_GRID_TOP_Y(row) + line;
+            uint32_t* out = (uint32_t*)&data[y * rowBytes];
+            uint32_t words[BLITTER_WORDS + 1] = { 0 };
+
+            for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+                uint32_t bits = cells[col][line];
+                int start = BLITTER_FIRST_BIT + (col * MATRIX_GRID_CELL_SIZE);
+                int word = start / 32;
+                int shift = 32 - MATRIX_GRID_CELL_SIZE - (start % 32);
+
+                // Cells that straddle two words are split between them
+                if (shift >= 0) {
+                    words[word] |= bits << shift;
+                } else {
+                    words[word] |= bits >> -shift;
+                    words[word + 1] |= bits << (32 + shift);
+                }
+            }
+
+            for (int word = 0; word < BLITTER_WORDS; word++) {
+                uint32_t keep = blitter->keepMask[word];
+
+                STORE_WORD(&out[word], (LOAD_WORD(&out[word]) & keep) | (words[word] & ~keep));
+            }
+        }
+    }
+}
+
+// Invert the pixels of matrix rows [firstRow, lastRow]. Inverting again restores them
+void blitterInvertRows(const Blitter* blitter, int firstRow, int lastRow, uint8_t* data, int rowBytes) {
+    for (int y = MATRIX_GRID_TOP_Y(firstRow); y < MATRIX_GRID_TOP_Y(lastRow) + MATRIX_GRID_CELL_SIZE; y++) {
+        uint32_t* out = (uint32_t*)&data[y * rowBytes];
+
+        for (int word = 0; word < BLITTER_WORDS; word++) {
+            STORE_WORD(&out[word], LOAD_WORD(&out[word]) ^ ~blitter->keepMask[word]);
+        }
+    }
+}
+
+// Copy the matrix part of one pixel row to another
+static inline void copyLine(const Blitter* blitter, uint8_t* data, int rowBytes, int fromY, int toY) {
+    const uint32_t* in = (const uint32_t*)&data[fromY * rowBytes];
+    uint32_t* out = (uint32_t*)&data[toY * rowBytes];
+
+    for (int word = 0; word < BLITTER_WORDS; word++) {
+        uint32_t keep = blitter->keepMask[word];
+
+        STORE_WORD(&out[word], (LOAD_WORD(&out[word]) & keep) | (LOAD_WORD(&in[word]) & ~keep));
+    }
+}
+
+// Take rows out of the matrix image by moving the rows above them down, in a single pass from the bottom up
+// Bit N of removed is set for each matrix row N to take out. The rows left at the top keep their old pixels
+void blitterRemoveRows(const Blitter* blitter, uint32_t removed, uint8_t* data, int rowBytes) {
+    int from = MATRIX_GRID_ROWS - 1;
+
+    for (int to = MATRIX_GRID_ROWS - 1; to >= 0; to--, from--) {
+        while (from >= 0 && (removed & (1u << from)) != 0) {
+            from--;
+        }
+
+        if (from < 0) {
+            break;
+        }
+
+        if (from != to) {
+            for (int line = MATRIX_GRID_CELL_SIZE - 1; line >= 0; line--) {
+                copyLine(blitter, data, rowBytes, MATRIX_GRID_TOP_Y(from) + line, MATRIX_GRID_TOP_Y(to) + line);
+            }
+        }
+    }
+}
\ No newline at end of file
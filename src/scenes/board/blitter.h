@@ -0,0 +1,47 @@
+#ifndef SCENES_BOARD_BLITTER_H
+#define SCENES_BOARD_BLITTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pd_api.h"
+#include "matrix.h"
+
+// Draws the locked cells of the playfield matrix straight into 1-bit bitmap data.
+// Each pixel row of the matrix is put together from the block patterns in a few 32-bit words
+// and written out in one go, rather than drawing every cell through the SDK.
+
+// 32-bit frame buffer words the matrix touches on each pixel row
+#define BLITTER_FIRST_WORD ((MATRIX_START_X) / 32)
+#define BLITTER_FIRST_BIT ((MATRIX_START_X) % 32)
+#define BLITTER_WORDS ((BLITTER_FIRST_BIT + MATRIX_WIDTH + 31) / 32)
+
+// Size and screen position of a bitmap the blitter can draw to.
+// The matrix sits at the same place within each word as it does on screen
+#define BLITTER_BITMAP_X (BLITTER_FIRST_WORD * 32)
+#define BLITTER_BITMAP_WIDTH (BLITTER_WORDS * 32)
+
+typedef struct Blitter {
+    // Pixel rows of each piece's block with the leftmost pixel in the highest of MATRIX_GRID_CELL_SIZE bits.
+    // Set bits are white, same as the frame buffer
+    uint16_t patterns[7][MATRIX_GRID_CELL_SIZE];
+
+    // Frame buffer bits on each side of the matrix that are left as they are
+    uint32_t keepMask[BLITTER_WORDS];
+} Blitter;
+
+// Read the block patterns from the bitmaps for each piece (indexed by Piece)
+// Returns false if a bitmap can't be used, in which case the matrix should be drawn with the SDK
+bool blitterInit(Blitter* blitter, LCDBitmap* const blocks[7]);
+
+// Draw the locked cells of matrix rows [firstRow, lastRow]. Cells of the player piece are drawn empty
+// data is the first of the BLITTER_WORDS words of the top pixel row, rowBytes must be a multiple of 4
+void blitterDrawRows(const Blitter* blitter, const MatrixGrid matrix, int firstRow, int lastRow, uint8_t* data, int rowBytes);
+
+// Invert the pixels of matrix rows [firstRow, lastRow]. Inverting again restores them
+void blitterInvertRows(const Blitter* blitter, int firstRow, int lastRow, uint8_t* data, int rowBytes);
+
+// Take rows out of the matrix image by moving the rows above them down, in a single pass from the bottom up
+// Bit N of removed is set for each matrix row N to take out. The rows left at the top keep their old pixels
+void blitterRemoveRows(const Blitter* blitter, uint32_t removed, uint8_t* data, int rowBytes);
+
+#endif
\ No newline at end of file
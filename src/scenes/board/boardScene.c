@@ -1,13 +1,23 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <math.h>
 #include "pd_api.h"
 #include "../options/optionsScene.h"
+#include "../pause/pauseScene.h"
 #include "../title/titleScene.h"
 #include "boardScene.h"
 #include "assets.h"
 #include "matrix.h"
+#include "rules.h"
+#include "replay.h"
+#include "blitter.h"
+#include "bitboard.h"
+#include "hud.h"
+#include "cpu.h"
+#include "finesseTable.h"
+#include "miniBoard.h"
 #include "game.h"
 #include "asset.h"
 #include "global.h"
@@ -18,18 +28,32 @@
 #define PIECE_HEIGHT 30
 #define PIECE_WIDTH 20
 
-#define MAX_DIFFICULTY 20
+// Size of the pre-rendered player piece bitmaps, which fit every piece in any orientation
+#define PIECE_BITMAP_SIZE (MATRIX_GRID_CELL_SIZE * 4)
 
-#define DAS_CHARGE_DELAY 19
-#define DAS_REPEAT_DELAY 7
+// Rows covered by each chunk of blocks when topping out
+#define TOPOUT_CHUNK_ROWS (MATRIX_GRID_ROWS / 4)
 
-#define SOFTDROP_GRAVITY 2
+// Area blacked out on the game over screen, one cell wider than the matrix on each side
+#define GAMEOVER_X (MATRIX_GRID_LEFT_X(0) - MATRIX_GRID_CELL_SIZE)
+#define GAMEOVER_WIDTH (MATRIX_GRID_CELL_SIZE * 12)
+
+// Frames taken to black out the game over area
+#define GAMEOVER_WIPE_FRAMES (LCD_ROWS / 10)
 
 #define NEXT_BOX_X 38
 #define NEXT_BOX_Y 25
 #define NEXT_BOX_WIDTH 69
 #define NEXT_BOX_HEIGHT 32
 
+// Height of each piece preview, which is as wide as the Next box
+#define PREVIEW_SLOT_HEIGHT 26
+
+// Box below the Level box holding the previews after the first, which is shown in the Next box
+#define QUEUE_BOX_X NEXT_BOX_X
+#define QUEUE_BOX_Y 122
+#define QUEUE_BOX_WIDTH NEXT_BOX_WIDTH
+
 #define LEVEL_BOX_X 38
 #define LEVEL_BOX_Y 93
 #define LEVEL_BOX_WIDTH 69
@@ -50,53 +74,27 @@
 #define SEED_BOX_WIDTH 69
 #define SEED_BOX_HEIGHT 15
 
+// CPU's board in versus mode, centered under the Score box where the Lines and Seed boxes usually are
+#define MINI_BOARD_X (LINES_BOX_X + ((LINES_BOX_WIDTH - MINI_BOARD_WIDTH) / 2))
+#define MINI_BOARD_Y LINES_BOX_Y
+
+// Blocks used for garbage lines sent by the CPU
+#define GARBAGE_PIECE I
+
 #define GAMEOVER_FONT_SIZE 18
+#define BUTTON_FONT_SIZE 12
+
+#define BOARD_FONT_COUNT 3
+
+// Time spent loading assets on each frame while the previous scene is still running
+// Half a frame at MENU_FPS, so menus stay responsive while a cold start loads in a few frames
+#define PREFETCH_BUDGET_MS 25
 
 #define BUTTON_Y SEED_BOX_Y
 #define BUTTON_X MATRIX_GRID_LEFT_X(0) - (MATRIX_GRID_CELL_SIZE / 2)
 #define BUTTON_HEIGHT (int)(MATRIX_GRID_CELL_SIZE * 2.5)
 #define BUTTON_WIDTH MATRIX_WIDTH + MATRIX_GRID_CELL_SIZE
 
-// Limit score to 999,999
-#define MAX_SCORE 999999
-
-// Score is calculated based on the number of lines completed in one drop & the current difficulty
-static int SCORING[4] = {
-    40,
-    100,
-    300,
-    1200
-};
-
-#define ARE_FRAMES 2
-#define LINECLEAR_FRAMES 77
-#define TOPOUT_FRAMES 45
-
-typedef enum Status {
-    // Lasts 1 frame, piece(s) are selected and the active piece is placed at the top of the screen
-    Start,
-
-    // Lasts 2 frames where the active piece is idle at the top of the screen
-    ARE,
-
-    // Piece is dropping and the player has control
-    Dropping,
-
-    // Piece has settled into a spot
-    Settled,
-
-    // Player has completed at least one line that needs cleared out
-    LineClear,
-
-    // Player has reached the top and the game must end
-    // Fills play area with blocks
-    // Lasts 45 frames then switches to GameOver state
-    TopOut,
-
-    // Display game over text and buttons for restarting game
-    GameOver
-} Status;
-
 // Houses a list of completed rows during a round
 typedef struct CompletedRows {
     int rows[4];
@@ -121,6 +119,12 @@ typedef struct SceneState {
     bool music;
     bool sounds;
 
+    // Whether to outline where the player piece will land
+    bool ghost;
+
+    // Whether blocks left floating by a line clear fall until they land, possibly completing more lines
+    bool cascade;
+
     PDMenuItem* musicMenuItem;
     PDMenuItem* soundsMenuItem;
 
@@ -134,18 +138,40 @@ typedef struct SceneState {
 
     int score;
 
+    // Number of pieces locked into the matrix
+    int pieces;
+
+    // Left, right, A and B presses made while the player piece was dropping
+    int pieceInputs;
+
+    // Pieces locked with more inputs than the finesse table says they needed
+    int finesseFaults;
+
     unsigned int gravityFrames;
 
     // Holds the state of each cell in the matrix
     MatrixGrid matrix;
 
+    // Locked cells of the matrix by column, used to find where the player piece lands
+    Bitboard bitboard;
+    BitboardColumns columns;
+
+    // Where the player piece would land
+    Position ghostPosition;
+
+    // Where the ghost outline is on screen. Only valid while ghostShown is set
+    Position drawnGhostPosition;
+    bool ghostShown;
+
     // Current player piece being controlled
     Piece playerPiece;
 
     // Current position of the player piece. X/Y coords are the top-left block of a piece and can be negative
     Position playerPosition;
 
-    Piece standbyPiece;
+    // Pieces coming up after the player piece, next first
+    Piece previewQueue[PREVIEW_MAX_PIECES];
+    int previewPieces;
 
     DasState das;
 
@@ -164,50 +190,120 @@ typedef struct SceneState {
 
     // Tracks which rows were completed during LineClear state
     CompletedRows roundCompletedRows;
+    // Whether the completed rows are shown flashed. The blitter inverts them in place,
+    // so they're only inverted again when this needs to change
+    bool rowsFlashed;
 
     // Form that is displayed on game over screen
     Form* gameOverForm;
+
+    // Records the buttons pressed until the game ends. NULL if the replay couldn't be created or has been saved
+    ReplayRecorder* replay;
+
+    // Number boxes, which keep the values they last drew
+    HudNumber scoreBox;
+    HudNumber levelBox;
+    HudNumber linesBox;
+    HudNumber seedBox;
+
+    // Pieces currently drawn in each preview slot
+    Piece previewDrawn[PREVIEW_MAX_PIECES];
+
+    // Set while another scene, such as the pause overlay, is pushed over the board
+    bool suspended;
+
+    // Set by the Replay button. The game restarts at the start of the next frame
+    bool restartRequested;
+
+    // Set when the audio was freed for low power. It's only loaded again once the device resumes or a button is pressed
+    bool lowPower;
+
+    // Whether the game is played against the CPU, whose board is shown in place of the Lines and Seed boxes
+    bool versus;
+    CpuBoard cpu;
+    MiniBoard miniBoard;
+
+    // Garbage lines sent by the CPU, added when the player's next piece locks without clearing any lines
+    int pendingGarbage;
+    uint32_t garbageRng;
 } SceneState;
 
-// How many frames per row a piece drops from gravity
-static int DIFFICULTY_LEVELS[21] = {
-    44,
-    41,
-    37,
-    34,
-    31,
-    27,
-    23,
-    18,
-    14,
-    9,
-    8,
-    7,
-    7,
-    6,
-    5,
-    5,
-    4,
-    4,
-    3,
-    3,
-    2
-};
+// Parts of the assets loaded by each call to loadAssetsStep
+typedef enum LoadStep {
+    LoadFonts,
+    LoadBitmaps,
+    LoadPieceBitmaps,
+    LoadOverlays,
+    LoadHudDigits,
+    LoadSamples,
+    LoadAudioPlayers,
+    LoadDone
+} LoadStep;
+
+// Fonts for the boxes, buttons and the game over screen
+static const int boardFontSizes[BOARD_FONT_COUNT] = { DEFAULT_FONT_SIZE, BUTTON_FONT_SIZE, GAMEOVER_FONT_SIZE };
+
+// Progress through loading the assets. Restarted whenever a board scene is created
+static LoadStep loadStep = LoadFonts;
+static int loadIndex = 0;
 
 // Assets
 static BoardSceneBitmapAssets* bitmapAssets = NULL;
 static BoardSceneSampleAssets* sampleAssets  = NULL;
 
+// Locked cells of the matrix, kept offscreen so the area under the player piece can be restored in one draw
+// Drawn to the screen at BLITTER_BITMAP_X so the matrix lines up with the blitter's words
+static LCDBitmap* stackBitmap = NULL;
+
+// Player piece in every orientation, with empty cells transparent
+static LCDBitmap* pieceBitmaps[7][4] = { { NULL } };
+
+// Outline of the player piece in every orientation, with empty cells transparent
+static LCDBitmap* ghostBitmaps[7][4] = { { NULL } };
+
+// Each piece centered on a white background the size of a preview slot
+static LCDBitmap* previewBitmaps[7] = { NULL };
+
+// Block patterns for drawing the stack bitmap without the SDK
+// Only used if the block bitmaps and stack bitmap data could be read
+static Blitter blitter;
+static bool blitterReady = false;
+
+// Chunk of blocks covering TOPOUT_CHUNK_ROWS rows of the matrix
+static LCDBitmap* topOutBitmap = NULL;
+
+// Blacked out game over area with the "Game Over" text
+static LCDBitmap* gameOverBitmap = NULL;
+
+// Height blacked out on each frame of the game over wipe, easing out along a sine curve
+static int gameOverWipeHeights[GAMEOVER_WIPE_FRAMES + 1];
+
+// Digits for the number boxes, rendered once from the default font
+static HudDigits hudDigits = { NULL, 0, 0 };
+
+// SDK draw calls made for the matrix on the current frame. Logged every frame when built with DRAW_STATS
+static unsigned int drawCalls = 0;
+
 // Music player
 static FilePlayer* musicPlayer = NULL;
 
+// Where the music was when its player was freed, so it picks up from there once loaded again
+static float musicOffset = 0;
+
 // Sound effects
 static SamplePlayer* samplePlayer = NULL;
 
 // Function prototpes
 
+static bool prefetchScene(Scene* scene);
 static void initAudioPlayers(void);
-static void loadAssets(void);
+static bool loadAssetsStep(void);
+static void nextLoadStep(void);
+static void renderPieceBitmaps(void);
+static void renderOverlays(void);
+static void freeAudio(void);
+static void freeAssets(void);
+static void freeBitmap(LCDBitmap** bitmap);
 
 // Frame update handlers
 static bool updateSceneStart(SceneState* state);
@@ -223,33 +319,44 @@ static void changeStatus(SceneState* state, Status status);
 static void updateDasCounts(DasState* state, PDButtons buttons);
 static int dasRepeatCheck(DasState* state);
 
-static void drawMatrix(MatrixGrid matrix, bool forceFull);
+static void renderStack(const MatrixGrid matrix, int firstRow, int lastRow);
+static void showStack(int firstRow, int lastRow);
+static void drawPlayerPiece(SceneState* state, const Position* previous, bool showGhost);
+static void restoreStackArea(Position pos);
+static bool areasOverlap(Position a, Position b);
+static void flashCompletedRows(SceneState* state, bool restore);
+static void collapseStack(const MatrixGrid matrix, const CompletedRows* completed);
+static bool cascadeStack(SceneState* state);
 
 static LCDBitmap* blockBitmapForPiece(Piece piece);
-
-static Position determineDroppedPosition(const MatrixGrid matrix, Piece piece, Position pos);
-
-static int difficultyForLines(int initialDifficulty, int completedLines);
-static inline int gravityFramesForDifficulty(int difficulty);
+static LCDBitmap* lockedBlockBitmap(const MatrixCell* cell);
 
 static void drawAllBoxes(SceneState* state);
-static void drawBoxText(const char* text, int x, int y, int width, int height);
+static bool showCpuBoard(SceneState* state);
 static void drawBoxPiece(Piece piece, int x, int y, int width, int height);
 
 static CompletedRows getCompletedRows(const MatrixGrid matrix);
 static bool canSettlePiece(const MatrixGrid matrix, Piece piece, Position pos);
 
+static bool updateCpu(SceneState* state);
+static bool addGarbage(SceneState* state);
+static void sendGarbage(SceneState* state, int numLines);
+
 static void playMusic(SceneState* state);
 static void stopMusic(void);
 static bool isMusicPlaying(void);
 
 static void playSample(SceneState* state, AudioSample* sample);
 
-static int incrementScore(int current, int add);
-
 static void handleMusicMenu(void* userdata);
 static void handleSoundMenu(void* userdata);
-static void handleEndGameMenu(void* userdata);
+static void handlePauseMenu(void* userdata);
+static void endGameHandler(void* data);
+
+static void drawBoard(SceneState* state);
+static uint16_t replayFlags(const SceneState* state);
+static void resetGameState(SceneState* state);
+static void restartGame(SceneState* state);
 
 
 // Handle when scene becomes active
@@ -259,19 +366,22 @@ static void initScene(Scene* scene) {
     // Seed the random number generator
     rand_seed(state->seed);
 
-    initAudioPlayers();
-    loadAssets();
-
-    // Clear screen 
-    GFX->clear(kColorWhite);
+    // Sizes only used by other scenes are freed
+    textFreeFontsExcept(boardFontSizes, BOARD_FONT_COUNT);
+    textPreloadFonts(boardFontSizes, BOARD_FONT_COUNT);
 
-    // Draw background
-    if (bitmapAssets != NULL && bitmapAssets->background != NULL) {
-        GFX->drawBitmap(bitmapAssets->background, 0, 0, kBitmapUnflipped);
+    // Usually already done by prefetchScene while the previous scene was running
+    while (!loadAssetsStep()) {
     }
 
     matrixClear(state->matrix);
-    drawMatrix(state->matrix, false);
+    bitboardInit();
+    bitboardClear(state->bitboard);
+    bitboardBuildColumns(state->bitboard, state->columns);
+    state->ghostShown = false;
+
+    renderStack(state->matrix, 0, MATRIX_GRID_ROWS - 1);
+    drawBoard(state);
 
     // Start playing music and loop forever
     playMusic(state);
@@ -280,15 +390,167 @@ static void initScene(Scene* scene) {
     SYS->removeAllMenuItems();
     state->musicMenuItem = SYS->addCheckmarkMenuItem("Music", state->music ? 1 : 0, handleMusicMenu, state);
     state->soundsMenuItem = SYS->addCheckmarkMenuItem("SFX", state->sounds ? 1 : 0, handleSoundMenu, state);
-    SYS->addMenuItem("End Game", handleEndGameMenu, state);
+    SYS->addMenuItem("Pause", handlePauseMenu, state);
+
+    state->replay = replayRecorderCreate(state->seed, state->initialDifficulty, replayFlags(state));
+}
+
+// Draws everything but the player piece and the boxes' contents, such as when the scene starts or resumes
+static void drawBoard(SceneState* state) {
+    // Clear screen 
+    GFX->clear(kColorWhite);
+
+    // Draw background
+    if (bitmapAssets != NULL && bitmapAssets->background != NULL) {
+        GFX->drawBitmap(bitmapAssets->background, 0, 0, kBitmapUnflipped);
+    }
+
+    showStack(0, MATRIX_GRID_ROWS - 1);
+    state->rowsFlashed = false;
+
+    // The background was just drawn over every box
+    hudNumberInit(&state->scoreBox, SCORE_BOX_X, SCORE_BOX_Y, SCORE_BOX_WIDTH, SCORE_BOX_HEIGHT, 10, 1);
+    hudNumberInit(&state->levelBox, LEVEL_BOX_X, LEVEL_BOX_Y, LEVEL_BOX_WIDTH, LEVEL_BOX_HEIGHT, 10, 1);
+    hudNumberInit(&state->linesBox, LINES_BOX_X, LINES_BOX_Y, LINES_BOX_WIDTH, LINES_BOX_HEIGHT, 10, 1);
+    hudNumberInit(&state->seedBox, SEED_BOX_X, SEED_BOX_Y, SEED_BOX_WIDTH, SEED_BOX_HEIGHT, 16, 8);
+
+    // The CPU's board covers the Lines and Seed boxes
+    if (state->versus) {
+        GFX->fillRect(MINI_BOARD_X - 2, MINI_BOARD_Y - 2, MINI_BOARD_WIDTH + 4, MINI_BOARD_HEIGHT + 4, kColorWhite);
+        GFX->drawRect(MINI_BOARD_X - 1, MINI_BOARD_Y - 1, MINI_BOARD_WIDTH + 2, MINI_BOARD_HEIGHT + 2, kColorBlack);
+
+        miniBoardInvalidate(&state->miniBoard);
+        showCpuBoard(state);
+    }
+
+    for (int i = 0; i < PREVIEW_MAX_PIECES; i++) {
+        state->previewDrawn[i] = None;
+    }
+
+    // Frame the queue box if more than one piece is previewed
+    if (state->previewPieces > 1) {
+        int queueHeight = (state->previewPieces - 1) * PREVIEW_SLOT_HEIGHT;
+
+        GFX->fillRect(QUEUE_BOX_X - 2, QUEUE_BOX_Y - 2, QUEUE_BOX_WIDTH + 4, queueHeight + 4, kColorWhite);
+        GFX->drawRect(QUEUE_BOX_X - 1, QUEUE_BOX_Y - 1, QUEUE_BOX_WIDTH + 2, queueHeight + 2, kColorBlack);
+    }
+}
+
+// Handle when a scene is pushed over the board
+// Everything is kept as it is, only the music is paused
+static void suspendScene(Scene* scene) {
+    SceneState* state = (SceneState*)scene->data;
+
+    state->suspended = true;
+
+    if (musicPlayer != NULL && isMusicPlaying()) {
+        SND->fileplayer->pause(musicPlayer);
+    }
+}
+
+// Handle when the scene pushed over the board is popped
+// The stack and pre-rendered bitmaps are still loaded, so only the screen is redrawn
+static void resumeScene(Scene* scene) {
+    SceneState* state = (SceneState*)scene->data;
+
+    state->suspended = false;
+
+    drawBoard(state);
+
+    // The player piece is only on screen until it's added to the stack
+    if (state->status == Dropping || state->status == Settled) {
+        state->ghostShown = false;
+        drawPlayerPiece(state, NULL, state->ghost);
+    }
+
+    drawAllBoxes(state);
+
+    playMusic(state);
+}
+
+// Handle system events while the board is the active scene
+static void handleSystemEvent(Scene* scene, PDSystemEvent event) {
+    SceneState* state = (SceneState*)scene->data;
+
+    switch (event) {
+        case kEventPause:
+        case kEventLock:
+            // The board isn't updated until the game resumes, so the music is held where it is
+            if (isMusicPlaying()) {
+                SND->fileplayer->pause(musicPlayer);
+            }
+            break;
+
+        case kEventResume:
+        case kEventUnlock:
+            state->lowPower = false;
+
+            // Music is stopped for good once the game ends
+            if (state->status < TopOut) {
+                playMusic(state);
+            }
+            break;
+
+        case kEventLowPower:
+            freeAudio();
+            state->lowPower = true;
+            break;
+
+        case kEventTerminate:
+            freeAssets();
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Memory held by the board while suspended. The assets shared by every board aren't included
+static size_t sceneFootprint(Scene* scene) {
+    SceneState* state = (SceneState*)scene->data;
+
+    size_t bytes = sizeof(Scene) + sizeof(SceneState) + sizeof(Form);
+
+    if (state->replay != NULL) {
+        bytes += sizeof(ReplayRecorder);
+    }
+
+    // 1 bit per pixel, with rows padded to 32 bits
+    if (state->miniBoard.bitmap != NULL) {
+        bytes += ((MINI_BOARD_WIDTH + 31) / 32) * 4 * MINI_BOARD_HEIGHT;
+    }
+
+    return bytes;
 }
 
 // Called on every frame while scene is active
 static bool updateScene(Scene* scene) {
     SceneState* state = (SceneState*)scene->data;
     PDButtons buttons;
+    PDButtons pushed;
+
+    // Replay was pressed on the last frame
+    if (state->restartRequested) {
+        restartGame(state);
+    }
 
-    SYS->getButtonState(&buttons, NULL, NULL);
+    SYS->getButtonState(&buttons, &pushed, NULL);
+
+    // The player is back after low power
+    if (pushed != 0) {
+        state->lowPower = false;
+    }
+
+    // Assets freed under low power are loaded again a step at a time once the device is in use again.
+    // Music starts again once its player is back
+    if (loadStep != LoadDone && !state->lowPower && loadAssetsStep() && state->status < TopOut && !state->suspended && !isMusicPlaying()) {
+        playMusic(state);
+    }
+
+    // Record buttons for every frame the game is in play
+    if (state->replay != NULL && state->status < TopOut) {
+        replayRecorderAddFrame(state->replay, buttons, pushed);
+    }
 
     updateDasCounts(&(state->das), buttons);
 
@@ -324,26 +586,53 @@ static bool updateScene(Scene* scene) {
             break;
     }
 
+    // The CPU plays along for as long as the player's game is going
+    if (state->versus && state->status < TopOut) {
+        screenUpdated = updateCpu(state) || screenUpdated;
+    }
+
+    // Save the replay once the game has ended
+    if (state->replay != NULL && state->status >= TopOut) {
+        replayRecorderFinish(state->replay, state->score, state->completedLines, state->difficulty, state->pieces, state->finesseFaults);
+        state->replay = NULL;
+    }
+
+#ifdef DRAW_STATS
+    if (drawCalls > 0) {
+        SYS->logToConsole("Matrix draw calls: %u", drawCalls);
+    }
+#endif
+
+    drawCalls = 0;
+
     return screenUpdated;
 }
 
 // Called on frame update when in the "Start" state status
 // Only runs for 1 frame and sets the active player piece
 static bool updateSceneStart(SceneState* state) {
-    // On the first time this is called both player and standby pieces need to be picked
-    if (state->standbyPiece != None) {
-        state->playerPiece = state->standbyPiece;
+    // On the first time this is called both the player piece and the preview queue need to be picked
+    if (state->previewQueue[0] != None) {
+        state->playerPiece = state->previewQueue[0];
+
+        for (int i = 1; i < state->previewPieces; i++) {
+            state->previewQueue[i - 1] = state->previewQueue[i];
+        }
+
+        // Randomly select the last piece in line
+        state->previewQueue[state->previewPieces - 1] = rand_next() % 7;
     } else {
         state->playerPiece = rand_next() % 7;
-    }
 
-    // Randomly select the next piece in line
-    state->standbyPiece = rand_next() % 7;
+        for (int i = 0; i < state->previewPieces; i++) {
+            state->previewQueue[i] = rand_next() % 7;
+        }
+    }
 
     // Place the player piece up top the matrix in the default orientation
-    state->playerPosition.col = 4;
+    state->playerPosition.col = SPAWN_COL;
     state->playerPosition.row = 0;
-    state->playerPosition.orientation = 0;
+    state->playerPosition.orientation = SPAWN_ORIENTATION;
 
     Position playerPos = state->playerPosition;
 
@@ -355,19 +644,26 @@ static bool updateSceneStart(SceneState* state) {
     // Draw the new player piece even if it overwrites an existing piece
     matrixAddPiecePoints(state->matrix, state->playerPiece, true, &playerPoints);
 
-    drawMatrix(state->matrix, false);
+    // There's nowhere to land when topping out
+    bool showGhost = state->ghost && canPlotPoints;
+
+    if (showGhost) {
+        state->ghostPosition = bitboardColumnsDropPosition(state->columns, state->playerPiece, playerPos);
+    }
+
+    drawPlayerPiece(state, NULL, showGhost);
 
     if (!canPlotPoints) {
         changeStatus(state, TopOut);
     } else {
         // Adjust difficulty based off how many lines have been completed
-        state->difficulty = difficultyForLines(state->initialDifficulty, state->completedLines);
+        state->difficulty = rulesDifficultyForLines(state->initialDifficulty, state->completedLines);
 
-        // Update all boxes
+        // Update boxes whose values changed
         drawAllBoxes(state);
 
         // Set gravity based on current difficulty
-        state->gravityFrames = gravityFramesForDifficulty(state->difficulty);
+        state->gravityFrames = rulesGravityFramesForDifficulty(state->difficulty);
 
         // Reset soft drop
         state->softDropInitiated = false;
@@ -376,6 +672,8 @@ static bool updateSceneStart(SceneState* state) {
         // Reset hard drop
         state->hardDropInitiated = false;
         state->hardDropStartingRow = 0;
+
+        state->pieceInputs = 0;
         
         // After a piece is selected, switch to ARE state
         changeStatus(state, ARE);
@@ -405,6 +703,23 @@ static bool updateSceneDropping(SceneState* state) {
     
     SYS->getButtonState(&currentKeys, &pressedKeys, NULL);
 
+    // Count inputs for finesse. Holding a direction for DAS is a single press
+    if ((pressedKeys & kButtonLeft) == kButtonLeft) {
+        state->pieceInputs++;
+    }
+
+    if ((pressedKeys & kButtonRight) == kButtonRight) {
+        state->pieceInputs++;
+    }
+
+    if ((pressedKeys & kButtonA) == kButtonA) {
+        state->pieceInputs++;
+    }
+
+    if ((pressedKeys & kButtonB) == kButtonB) {
+        state->pieceInputs++;
+    }
+
     // If DOWN is newly pressed, force soft drop gravity
     // Ignore if any other direction button is pressed too
     if ((pressedKeys & 0xF) == kButtonDown) {
@@ -425,7 +740,7 @@ static bool updateSceneDropping(SceneState* state) {
         if (state->softDropInitiated && ((currentKeys & 0xF) == kButtonDown)) {
             state->gravityFrames = SOFTDROP_GRAVITY;
         } else {
-            state->gravityFrames = gravityFramesForDifficulty(state->difficulty);
+            state->gravityFrames = rulesGravityFramesForDifficulty(state->difficulty);
             state->softDropInitiated = false;
         }
     }
@@ -448,7 +763,7 @@ static bool updateSceneDropping(SceneState* state) {
 
         // If UP is pressed, immediately drop piece and settle it
         if ((pressedKeys & kButtonUp) == kButtonUp) {
-            finalPos = determineDroppedPosition(state->matrix, state->playerPiece, finalPos);
+            finalPos = bitboardColumnsDropPosition(state->columns, state->playerPiece, finalPos);
             shouldSettle = true;
 
             // Keep track of where the piece was when the soft drop was initiated so it can be scored after it settles
@@ -521,8 +836,13 @@ static bool updateSceneDropping(SceneState* state) {
 
             state->playerPosition = finalPos;
 
+            // The landing row only changes when the piece moves sideways or rotates
+            if (state->ghost && (currentPos.col != finalPos.col || currentPos.orientation != finalPos.orientation)) {
+                state->ghostPosition = bitboardColumnsDropPosition(state->columns, state->playerPiece, finalPos);
+            }
+
             screenUpdated = true;
-            drawMatrix(state->matrix, false);
+            drawPlayerPiece(state, &currentPos, state->ghost);
         }
 
         if (shouldSettle) {
@@ -545,6 +865,34 @@ static bool updateSceneSettled(SceneState* state) {
 
     // Clear out player indicator
     matrixClearPlayerIndicator(state->matrix);
+    state->pieces++;
+
+    // A piece that took more inputs than it needed to reach its orientation and column is a finesse fault
+    uint8_t finesseInputs = FINESSE_INPUTS[state->playerPiece][state->playerPosition.orientation][state->playerPosition.col + FINESSE_COL_OFFSET];
+
+    if (finesseInputs != FINESSE_UNREACHABLE && state->pieceInputs > finesseInputs) {
+        state->finesseFaults++;
+    }
+
+    // Lock the piece into the stack bitmap. It's already on screen
+    MatrixPiecePoints lockedPoints = matrixGetPointsForPiece(state->playerPiece, state->playerPosition.col, state->playerPosition.row, state->playerPosition.orientation);
+
+    if (lockedPoints.numPoints > 0) {
+        int firstRow = lockedPoints.points[0][1];
+        int lastRow = lockedPoints.points[lockedPoints.numPoints - 1][1];
+
+        renderStack(state->matrix, firstRow, lastRow);
+
+        // The ghost outline sits under the locked piece and shows through its transparent pixels
+        if (state->ghostShown) {
+            showStack(firstRow, lastRow);
+            state->ghostShown = false;
+            screenUpdated = true;
+        }
+    }
+
+    bitboardAddPiece(state->bitboard, state->playerPiece, state->playerPosition);
+    bitboardBuildColumns(state->bitboard, state->columns);
 
     // Get any completed rows
     // If there were any, then they will be cleared out in the LineClear state
@@ -553,17 +901,25 @@ static bool updateSceneSettled(SceneState* state) {
     // Score soft dropped pieces
     // Score is increased by the number of rows since soft drop was initiated
     if (state->softDropInitiated) {
-        state->score = incrementScore(state->score, (state->playerPosition.row - state->softDropStartingRow));
+        state->score = rulesIncrementScore(state->score, (state->playerPosition.row - state->softDropStartingRow));
     }
 
     // Score hard dropped pieces
     // Score is increased by the number of rows dropped * 2
     if (state->hardDropInitiated) {
-        state->score = incrementScore(state->score, ((state->playerPosition.row - state->hardDropStartingRow) * 2));
+        state->score = rulesIncrementScore(state->score, ((state->playerPosition.row - state->hardDropStartingRow) * 2));
     }
 
-    // If there were any completed lines, go into LineClear state. Else reset to Start state
-    changeStatus(state, state->roundCompletedRows.numRows > 0 ? LineClear : Start);
+    // If there were any completed lines, go into LineClear state
+    // Else any garbage sent by the CPU is added and reset to Start state
+    if (state->roundCompletedRows.numRows > 0) {
+        changeStatus(state, LineClear);
+    } else if (state->pendingGarbage > 0) {
+        changeStatus(state, addGarbage(state) ? Start : TopOut);
+        screenUpdated = true;
+    } else {
+        changeStatus(state, Start);
+    }
 
     return screenUpdated;
 }
@@ -571,27 +927,50 @@ static bool updateSceneSettled(SceneState* state) {
 // Called on frame update when in the "LineClear" state
 // Lasts for 77 frames
 static bool updateSceneLineClear(SceneState* state) {
+    bool screenUpdated = false;
+
     // On last frame of LineClear, clear the completed lines and score it
     if (state->statusFrames++ == LINECLEAR_FRAMES) {
         matrixRemoveRows(state->matrix, (int*)state->roundCompletedRows.rows, state->roundCompletedRows.numRows);
 
-        drawMatrix(state->matrix, true);
+        uint32_t removedRows = 0;
+
+        for (int i = 0; i < state->roundCompletedRows.numRows; i++) {
+            removedRows |= 1u << state->roundCompletedRows.rows[i];
+        }
+
+        bitboardRemoveRows(state->bitboard, removedRows);
+        bitboardBuildColumns(state->bitboard, state->columns);
+
+        collapseStack(state->matrix, &(state->roundCompletedRows));
+        state->rowsFlashed = false;
+        screenUpdated = true;
 
         // Score completed rows
-        state->score = incrementScore(state->score, SCORING[state->roundCompletedRows.numRows - 1] * (state->difficulty + 1));
+        state->score = rulesIncrementScore(state->score, rulesScoreForLines(state->roundCompletedRows.numRows, state->difficulty));
         state->completedLines += state->roundCompletedRows.numRows;
 
-        changeStatus(state, Start);
+        if (state->versus) {
+            sendGarbage(state, state->roundCompletedRows.numRows);
+        }
+
+        // Loose blocks fall and any rows they complete are cleared as a chain
+        if (state->cascade) {
+            cascadeStack(state);
+            state->roundCompletedRows = getCompletedRows(state->matrix);
+        } else {
+            state->roundCompletedRows.numRows = 0;
+        }
+
+        changeStatus(state, state->roundCompletedRows.numRows > 0 ? LineClear : Start);
     } else {
         // Every 10 frames flash the completed rows
         if (state->statusFrames % 20 == 0) {
-            drawMatrix(state->matrix, true);
+            flashCompletedRows(state, true);
+            screenUpdated = true;
         } else if (state->statusFrames % 10 == 0) {
-            for (int i = 0; i < state->roundCompletedRows.numRows; i++) {
-                int row = state->roundCompletedRows.rows[i];
-
-                GFX->fillRect(MATRIX_START_X, MATRIX_GRID_TOP_Y(row), MATRIX_WIDTH, MATRIX_GRID_CELL_SIZE, kColorWhite);
-            }
+            flashCompletedRows(state, false);
+            screenUpdated = true;
 
             if (sampleAssets != NULL && sampleAssets->perc != NULL) {
                 playSample(state, sampleAssets->perc);
@@ -599,7 +978,7 @@ static bool updateSceneLineClear(SceneState* state) {
         } 
     }
 
-    return true;
+    return screenUpdated;
 }
 
 // Called on frame update when in the "TopOut" state
@@ -616,21 +995,13 @@ static bool updateSceneTopOut(SceneState* state) {
     if (state->statusFrames <= TOPOUT_FRAMES) {
         if ((state->statusFrames % 15) == 0) {
             int i = state->statusFrames / 15;
-            int startRow = (MATRIX_GRID_ROWS - 1) - (i * (MATRIX_GRID_ROWS / 4));
-            int endRow = startRow - (MATRIX_GRID_ROWS / 4);
-
-            for (int row = startRow; row > endRow; row--) {
-                int y = MATRIX_GRID_TOP_Y(row);
-
-                for (int col = 0; col < MATRIX_GRID_COLS; col++) {
-                    int x = MATRIX_GRID_LEFT_X(col);
+            int topRow = MATRIX_GRID_ROWS - ((i + 1) * TOPOUT_CHUNK_ROWS);
 
-                    GFX->drawBitmap(bitmapAssets->column, x, y, kBitmapUnflipped);
-                    screenUpdated = true;
-                }
+            if (topOutBitmap != NULL) {
+                GFX->drawBitmap(topOutBitmap, MATRIX_GRID_LEFT_X(0), MATRIX_GRID_TOP_Y(topRow), kBitmapUnflipped);
+                screenUpdated = true;
             }
 
-
             playSample(state, sampleAssets->kick);
         }
 
@@ -651,49 +1022,34 @@ static bool updateSceneGameOver(SceneState* state) {
     }
 
 
-    double endPct = (float)state->statusFrames / (float)(LCD_ROWS / 10);
+    if (state->statusFrames <= GAMEOVER_WIPE_FRAMES) {
+        // Only the band uncovered since the last frame is filled
+        int top = state->statusFrames > 0 ? gameOverWipeHeights[state->statusFrames - 1] : 0;
+        int bottom = gameOverWipeHeights[state->statusFrames];
 
-    if (endPct <= 1) {
-        int endY = (int)(sin((endPct * 3.14159) / 2) * LCD_ROWS);
-
-        GFX->fillRect(MATRIX_GRID_LEFT_X(0) - MATRIX_GRID_CELL_SIZE, 0, MATRIX_GRID_CELL_SIZE * 12, endY, kColorBlack);
+        GFX->fillRect(GAMEOVER_X, top, GAMEOVER_WIDTH, bottom - top, kColorBlack);
 
         state->statusFrames++;
-    } else {
-        GFX->fillRect(MATRIX_GRID_LEFT_X(0) - MATRIX_GRID_CELL_SIZE, 0, MATRIX_GRID_CELL_SIZE * 12, LCD_ROWS, kColorBlack);
-
-        int gameOverX = MATRIX_GRID_LEFT_X(0);
-        int gameOverY = NEXT_BOX_Y + NEXT_BOX_HEIGHT;
-        int gameOverWidth = MATRIX_GRID_CELL_SIZE * 10;
-        int gameOverHeight = MATRIX_GRID_CELL_SIZE * 3;
-
-        int txtHeight = textHeight(GAMEOVER_FONT_SIZE);
-        int GaTxtWidth = textWidth("Ga", strlen("Ga"), GAMEOVER_FONT_SIZE);
-
-        int fullLengthWidth = textWidth("Gameer", strlen("Gameer"), GAMEOVER_FONT_SIZE);
-
-        int txtX = gameOverX + (gameOverWidth / 2) - (fullLengthWidth / 2);
-        int txtY = gameOverY + (gameOverHeight / 2) - (txtHeight * 2) / 2;
-
-        textDraw("Game", txtX, txtY, GAMEOVER_FONT_SIZE, kColorWhite);
-        textDraw("Over", txtX + GaTxtWidth, txtY + txtHeight, GAMEOVER_FONT_SIZE, kColorWhite);
+    } else if (state->statusFrames == GAMEOVER_WIPE_FRAMES + 1) {
+        // The game over screen is drawn once, after which only form fields that change are redrawn
+        if (gameOverBitmap != NULL) {
+            GFX->drawBitmap(gameOverBitmap, GAMEOVER_X, 0, kBitmapUnflipped);
+        } else {
+            GFX->fillRect(GAMEOVER_X, 0, GAMEOVER_WIDTH, LCD_ROWS, kColorBlack);
+        }
 
+        formInvalidate(state->gameOverForm);
         formUpdate(state->gameOverForm);
-    }
 
-    return true;
-}
+        // Only the form changes from here on
+        gameSetRefreshRate(MENU_FPS);
 
-// Determine where a piece would sit if it dropped straight down
-static Position determineDroppedPosition(const MatrixGrid matrix, Piece piece, Position pos) {
-    for (int row = pos.row; row < MATRIX_GRID_ROWS; row++) {
-        pos.row = row;
-        if (canSettlePiece(matrix, piece, pos)) {
-            break;
-        }
+        state->statusFrames++;
+    } else {
+        return formUpdate(state->gameOverForm);
     }
 
-    return pos;
+    return true;
 }
 
 // Change current status and rest status frame counter
@@ -759,6 +1115,13 @@ static void destroyScene(Scene* scene) {
     // Dispose of form
     formDestroy(state->gameOverForm);
 
+    miniBoardFree(&state->miniBoard);
+
+    // A game that never ended isn't worth keeping
+    if (state->replay != NULL) {
+        replayRecorderDiscard(state->replay);
+    }
+
     // Dispose of scene
     SYS->realloc(scene->data, 0);
     SYS->realloc(scene, 0);
@@ -772,41 +1135,48 @@ static void destroyScene(Scene* scene) {
 static void replayHandler(void* data) {
     SceneState* state = (SceneState*)data;
 
-    gameChangeScene(boardSceneCreate(state->seed, state->initialDifficulty, state->music, state->sounds));
+    // Restarting while the form is updating would change the state under it
+    state->restartRequested = true;
 }
 
-// Handle New Game button
-// Goes back to Options screen to start a new game
-// Gets passed the current scene state
-static void newGameHandler(void* data) {
-    SceneState* state = (SceneState*)data;
+// Rule variations recorded in the replay header
+static uint16_t replayFlags(const SceneState* state) {
+    uint16_t flags = 0;
 
-    gameChangeScene(optionsSceneCreate(state->music, state->sounds));
-}
+    if (state->versus) {
+        flags |= REPLAY_FLAG_VERSUS;
+    }
 
-// Create scene for Board scene
-Scene* boardSceneCreate(unsigned int seed, int initialDifficulty, bool music, bool sounds) {
-    Scene* scene = SYS->realloc(NULL, sizeof(Scene));
+    if (state->cascade) {
+        flags |= REPLAY_FLAG_CASCADE;
+    }
 
-    // Initialize scene state to default values
-    SceneState* state = SYS->realloc(NULL, sizeof(SceneState));
-    state->seed = seed;
-    state->initialDifficulty = initialDifficulty;
-    state->music = music;
-    state->sounds = sounds;
-    state->musicMenuItem = NULL;
-    state->soundsMenuItem = NULL;
-    state->difficulty = initialDifficulty;
+    return flags;
+}
+
+// Set everything that changes during a game back to how a new game starts
+static void resetGameState(SceneState* state) {
+    state->difficulty = state->initialDifficulty;
     state->completedLines = 0;
     state->score = 0;
-    state->gravityFrames = gravityFramesForDifficulty(initialDifficulty);
+    state->pieces = 0;
+    state->pieceInputs = 0;
+    state->finesseFaults = 0;
+    state->gravityFrames = rulesGravityFramesForDifficulty(state->initialDifficulty);
     state->status = Start;
     state->statusFrames = 0;
+    state->rowsFlashed = false;
     state->playerPiece = None;
     state->playerPosition.col = 0;
     state->playerPosition.row = 0;
     state->playerPosition.orientation = 0;
-    state->standbyPiece = None;
+    state->restartRequested = false;
+    state->lowPower = false;
+
+    for (int i = 0; i < PREVIEW_MAX_PIECES; i++) {
+        state->previewQueue[i] = None;
+    }
+
     state->das.charged = false;
     state->das.frames = 0;
     state->das.key = 0;
@@ -814,32 +1184,131 @@ Scene* boardSceneCreate(unsigned int seed, int initialDifficulty, bool music, bo
     state->softDropStartingRow = 0;
     state->hardDropInitiated = false;
     state->hardDropStartingRow = 0;
+    state->replay = NULL;
+
+    // The CPU gets the same seed so both boards see the same pieces, and starts on the same level
+    cpuReset(&state->cpu, state->seed, state->initialDifficulty, state->cascade);
+    state->pendingGarbage = 0;
+    state->garbageRng = rulesGarbageRngSeed(state->seed);
+}
+
+// Starts a new game with the same settings without leaving the scene
+// The form, menu items, audio players and everything drawn outside the game over area are kept,
+// so the first piece drops on this frame
+static void restartGame(SceneState* state) {
+    resetGameState(state);
+
+    rand_seed(state->seed);
 
-    // Create replay/new game forms
-    Form* form = formCreate();
-    state->gameOverForm = form;
-    
-    formAddField(form, formCreateButtonField((Dimensions){ .x = BUTTON_X, .y = BUTTON_Y, .width = BUTTON_WIDTH, .height = BUTTON_HEIGHT }, "Replay", 12, 12, state, replayHandler));
-    formAddField(form, formCreateButtonField((Dimensions){ .x = BUTTON_X, .y = BUTTON_Y + BUTTON_HEIGHT + 12, .width = BUTTON_WIDTH, .height = BUTTON_HEIGHT }, "New Game", 12, 12, state, newGameHandler));
-    
     matrixClear(state->matrix);
+    bitboardClear(state->bitboard);
+    bitboardBuildColumns(state->bitboard, state->columns);
+    state->ghostShown = false;
 
-    scene->name = "Board";
-    scene->init = initScene;
-    scene->update = updateScene;
-    scene->destroy = destroyScene;
-    scene->data = (void*)state;
+    renderStack(state->matrix, 0, MATRIX_GRID_ROWS - 1);
 
-    return scene;
-}
+    // Only the game over area was drawn over. The boxes pick up the new values as they change
+    GFX->setClipRect(GAMEOVER_X, 0, GAMEOVER_WIDTH, LCD_ROWS);
+    GFX->fillRect(GAMEOVER_X, 0, GAMEOVER_WIDTH, LCD_ROWS, kColorWhite);
 
-static void initAudioPlayers(void) {
-    // FilePlayer for music
-    if (musicPlayer == NULL) {
-        musicPlayer = SND->fileplayer->newPlayer();
-        if (!SND->fileplayer->loadIntoPlayer(musicPlayer, "sounds/its-raining-pixels")) {
+    if (bitmapAssets != NULL && bitmapAssets->background != NULL) {
+        GFX->drawBitmap(bitmapAssets->background, 0, 0, kBitmapUnflipped);
+    }
+
+    GFX->clearClipRect();
+
+    showStack(0, MATRIX_GRID_ROWS - 1);
+
+    // The game over screen drops to MENU_FPS
+    gameSetRefreshRate(FPS);
+
+    playMusic(state);
+
+    state->replay = replayRecorderCreate(state->seed, state->initialDifficulty, replayFlags(state));
+}
+
+// Handle New Game button
+// Goes back to Options screen to start a new game
+// Gets passed the current scene state
+static void newGameHandler(void* data) {
+    SceneState* state = (SceneState*)data;
+
+    gameChangeScene(optionsSceneCreate(state->music, state->sounds));
+}
+
+// Create scene for Board scene
+Scene* boardSceneCreate(unsigned int seed, int initialDifficulty, int previewPieces, bool ghost, bool music, bool sounds, bool versus, bool cascade) {
+    Scene* scene = SYS->realloc(NULL, sizeof(Scene));
+
+    // Fonts may have been freed by another scene since assets were last loaded
+    loadStep = LoadFonts;
+    loadIndex = 0;
+
+    // A new game starts its music from the beginning
+    musicOffset = 0;
+
+    // Initialize scene state to default values
+    SceneState* state = SYS->realloc(NULL, sizeof(SceneState));
+    state->seed = seed;
+    state->initialDifficulty = initialDifficulty;
+    state->music = music;
+    state->sounds = sounds;
+    state->musicMenuItem = NULL;
+    state->soundsMenuItem = NULL;
+    state->suspended = false;
+    state->ghost = ghost;
+    state->versus = versus;
+    state->cascade = cascade;
+    state->previewPieces = previewPieces < 1 ? 1 : (previewPieces > PREVIEW_MAX_PIECES ? PREVIEW_MAX_PIECES : previewPieces);
+
+    resetGameState(state);
+
+    for (int i = 0; i < PREVIEW_MAX_PIECES; i++) {
+        state->previewDrawn[i] = None;
+    }
+
+    // Without the bitmap the CPU still plays, it just can't be seen
+    state->miniBoard.bitmap = NULL;
+
+    if (versus && !miniBoardInit(&state->miniBoard, MINI_BOARD_X, MINI_BOARD_Y)) {
+        SYS->logToConsole("Unable to create the CPU board bitmap");
+    }
+
+    // Create replay/new game forms
+    Form* form = formCreate();
+    state->gameOverForm = form;
+    
+    formAddField(form, formCreateButtonField((Dimensions){ .x = BUTTON_X, .y = BUTTON_Y, .width = BUTTON_WIDTH, .height = BUTTON_HEIGHT }, "Replay", BUTTON_FONT_SIZE, BUTTON_FONT_SIZE, state, replayHandler));
+    formAddField(form, formCreateButtonField((Dimensions){ .x = BUTTON_X, .y = BUTTON_Y + BUTTON_HEIGHT + 12, .width = BUTTON_WIDTH, .height = BUTTON_HEIGHT }, "New Game", BUTTON_FONT_SIZE, BUTTON_FONT_SIZE, state, newGameHandler));
+    
+    matrixClear(state->matrix);
+
+    scene->name = "Board";
+    scene->init = initScene;
+    scene->prefetch = prefetchScene;
+    scene->update = updateScene;
+    scene->destroy = destroyScene;
+    scene->suspend = suspendScene;
+    scene->resume = resumeScene;
+    scene->handleEvent = handleSystemEvent;
+    scene->footprint = sceneFootprint;
+    // Gameplay timing is counted in frames at FPS
+    scene->refreshRate = FPS;
+    scene->data = (void*)state;
+
+    return scene;
+}
+
+static void initAudioPlayers(void) {
+    // FilePlayer for music
+    if (musicPlayer == NULL) {
+        musicPlayer = SND->fileplayer->newPlayer();
+        if (!SND->fileplayer->loadIntoPlayer(musicPlayer, "sounds/its-raining-pixels")) {
             SYS->logToConsole("Error loading music");
         }
+
+        SND->fileplayer->setOffset(musicPlayer, musicOffset);
+        musicOffset = 0;
     }
 
     // Sample player for Audio Samples
@@ -848,40 +1317,513 @@ static void initAudioPlayers(void) {
     }
 }
 
-// Preloads all assets
-static void loadAssets(void) {
-    if (bitmapAssets == NULL) {
-        bitmapAssets = loadBitmapAssets();
-    }
+// Called each frame while the previous scene is still running
+static bool prefetchScene(Scene* scene) {
+    (void)scene;
 
-    if (sampleAssets == NULL) {
-        sampleAssets = loadSampleAssets();
+    unsigned int started = SYS->getCurrentTimeMilliseconds();
+
+    // At least one step is loaded each frame, then as many more as fit in the budget
+    while (!loadAssetsStep()) {
+        if (SYS->getCurrentTimeMilliseconds() - started >= PREFETCH_BUDGET_MS) {
+            return false;
+        }
     }
+
+    return true;
 }
 
-// Draws all cells in the playfield matrix to the screen
-// forceFull will force drawing the whole grid if true, else will only draw blocks marked as dirty
-static void drawMatrix(MatrixGrid matrix, bool forceFull) {
-    for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
-        for (int col = 0; col < MATRIX_GRID_COLS; col++) {
-            if (forceFull || matrix[row][col].dirty) {
-                int x = MATRIX_GRID_LEFT_X(col);
-                int y = MATRIX_GRID_TOP_Y(row);
-                
-                if (matrix[row][col].filled) {
-                    LCDBitmap* block = blockBitmapForPiece(matrix[row][col].piece);
-
-                    if (block != NULL) {
-                        GFX->drawBitmap(block, x, y, kBitmapUnflipped);
+// Loads the next asset that isn't loaded yet, so loading can be spread over several frames
+// Returns true once everything the scene needs is loaded
+static bool loadAssetsStep(void) {
+    while (loadStep != LoadDone) {
+        switch (loadStep) {
+            case LoadFonts:
+                // One font at a time
+                while (loadIndex < BOARD_FONT_COUNT) {
+                    const int* size = &boardFontSizes[loadIndex++];
+
+                    if (!textFontLoaded(*size)) {
+                        textPreloadFonts(size, 1);
+                        return false;
+                    }
+                }
+
+                nextLoadStep();
+                break;
+
+            case LoadBitmaps:
+                if (bitmapAssets == NULL) {
+                    bitmapAssets = createBitmapAssets();
+                }
+
+                // One image at a time
+                while (bitmapAssets != NULL && loadIndex < BOARD_BITMAP_ASSET_COUNT) {
+                    if (loadBitmapAsset(bitmapAssets, loadIndex++)) {
+                        return false;
                     }
-                } else {
-                    GFX->fillRect(x, y, MATRIX_GRID_CELL_SIZE, MATRIX_GRID_CELL_SIZE, kColorWhite);
                 }
 
-                matrix[row][col].dirty = false;
+                nextLoadStep();
+                break;
+
+            case LoadPieceBitmaps:
+                nextLoadStep();
+
+                if (stackBitmap == NULL && bitmapAssets != NULL) {
+                    renderPieceBitmaps();
+                    return false;
+                }
+                break;
+
+            case LoadOverlays:
+                nextLoadStep();
+
+                if (topOutBitmap == NULL || gameOverBitmap == NULL) {
+                    renderOverlays();
+                    return false;
+                }
+                break;
+
+            case LoadHudDigits:
+                nextLoadStep();
+
+                if (hudDigits.table == NULL) {
+                    hudDigitsLoad(&hudDigits, getFontForSize(DEFAULT_FONT_SIZE));
+                    return false;
+                }
+                break;
+
+            case LoadSamples:
+                nextLoadStep();
+
+                if (sampleAssets == NULL) {
+                    sampleAssets = loadSampleAssets();
+                    return false;
+                }
+                break;
+
+            case LoadAudioPlayers:
+                nextLoadStep();
+
+                if (musicPlayer == NULL || samplePlayer == NULL) {
+                    initAudioPlayers();
+                    return false;
+                }
+                break;
+
+            case LoadDone:
+                break;
+        }
+    }
+
+    return true;
+}
+
+static void nextLoadStep(void) {
+    loadStep++;
+    loadIndex = 0;
+}
+
+// Frees the music player's streaming buffer and the sound effects, which are loaded again when the board next updates
+static void freeAudio(void) {
+    if (musicPlayer != NULL) {
+        musicOffset = SND->fileplayer->getOffset(musicPlayer);
+        SND->fileplayer->stop(musicPlayer);
+        SND->fileplayer->freePlayer(musicPlayer);
+        musicPlayer = NULL;
+    }
+
+    if (samplePlayer != NULL) {
+        SND->sampleplayer->stop(samplePlayer);
+        SND->sampleplayer->freePlayer(samplePlayer);
+        samplePlayer = NULL;
+    }
+
+    if (sampleAssets != NULL) {
+        freeSampleAssets(sampleAssets);
+        sampleAssets = NULL;
+    }
+
+    if (loadStep > LoadSamples) {
+        loadStep = LoadSamples;
+        loadIndex = 0;
+    }
+}
+
+// Frees every asset shared by board scenes
+static void freeAssets(void) {
+    freeAudio();
+
+    if (bitmapAssets != NULL) {
+        freeBitmapAssets(bitmapAssets);
+        bitmapAssets = NULL;
+    }
+
+    freeBitmap(&stackBitmap);
+    blitterReady = false;
+
+    for (int piece = 0; piece < 7; piece++) {
+        for (int orientation = 0; orientation < 4; orientation++) {
+            freeBitmap(&pieceBitmaps[piece][orientation]);
+            freeBitmap(&ghostBitmaps[piece][orientation]);
+        }
+
+        freeBitmap(&previewBitmaps[piece]);
+    }
+
+    freeBitmap(&topOutBitmap);
+    freeBitmap(&gameOverBitmap);
+
+    hudDigitsFree(&hudDigits);
+
+    loadStep = LoadFonts;
+    loadIndex = 0;
+}
+
+static void freeBitmap(LCDBitmap** bitmap) {
+    if (*bitmap != NULL) {
+        GFX->freeBitmap(*bitmap);
+        *bitmap = NULL;
+    }
+}
+
+// Pre-renders the stack bitmap, every piece and the preview slots
+static void renderPieceBitmaps(void) {
+    stackBitmap = GFX->newBitmap(BLITTER_BITMAP_WIDTH, MATRIX_HEIGHT, kColorWhite);
+
+    // Pre-render every piece in every orientation
+    for (int piece = 0; piece < 7; piece++) {
+        LCDBitmap* block = blockBitmapForPiece(piece);
+
+        for (int orientation = 0; orientation < 4; orientation++) {
+            LCDBitmap* bitmap = GFX->newBitmap(PIECE_BITMAP_SIZE, PIECE_BITMAP_SIZE, kColorClear);
+
+            if (bitmap != NULL && block != NULL) {
+                MatrixPiecePoints points = matrixGetPointsForPiece(piece, 0, 0, orientation);
+
+                GFX->pushContext(bitmap);
+
+                for (int i = 0; i < points.numPoints; i++) {
+                    GFX->drawBitmap(block, points.points[i][0] * MATRIX_GRID_CELL_SIZE, points.points[i][1] * MATRIX_GRID_CELL_SIZE, kBitmapUnflipped);
+                }
+
+                GFX->popContext();
             }
+
+            pieceBitmaps[piece][orientation] = bitmap;
+
+            LCDBitmap* ghostBitmap = GFX->newBitmap(PIECE_BITMAP_SIZE, PIECE_BITMAP_SIZE, kColorClear);
+
+            if (ghostBitmap != NULL) {
+                MatrixPiecePoints points = matrixGetPointsForPiece(piece, 0, 0, orientation);
+
+                GFX->pushContext(ghostBitmap);
+
+                for (int i = 0; i < points.numPoints; i++) {
+                    GFX->drawRect((points.points[i][0] * MATRIX_GRID_CELL_SIZE) + 1, (points.points[i][1] * MATRIX_GRID_CELL_SIZE) + 1, MATRIX_GRID_CELL_SIZE - 2, MATRIX_GRID_CELL_SIZE - 2, kColorBlack);
+                }
+
+                GFX->popContext();
+            }
+
+            ghostBitmaps[piece][orientation] = ghostBitmap;
+        }
+
+        // Pre-render the piece as it's shown in the Next and queue boxes
+        previewBitmaps[piece] = GFX->newBitmap(NEXT_BOX_WIDTH, PREVIEW_SLOT_HEIGHT, kColorWhite);
+
+        if (previewBitmaps[piece] != NULL) {
+            GFX->pushContext(previewBitmaps[piece]);
+            drawBoxPiece(piece, 0, 0, NEXT_BOX_WIDTH, PREVIEW_SLOT_HEIGHT);
+            GFX->popContext();
+        }
+    }
+
+    if (stackBitmap != NULL) {
+        LCDBitmap* blocks[7];
+        int width = 0;
+        int height = 0;
+        int rowBytes = 0;
+        uint8_t* data = NULL;
+
+        for (int piece = 0; piece < 7; piece++) {
+            blocks[piece] = blockBitmapForPiece(piece);
+        }
+
+        // The blitter writes whole words to each row of the stack bitmap
+        GFX->getBitmapData(stackBitmap, &width, &height, &rowBytes, NULL, &data);
+
+        blitterReady = data != NULL && (rowBytes % 4) == 0 && rowBytes >= BLITTER_WORDS * 4 && blitterInit(&blitter, blocks);
+    }
+}
+
+// Pre-renders the top out blocks and the game over screen
+static void renderOverlays(void) {
+    if (topOutBitmap == NULL && bitmapAssets != NULL && bitmapAssets->column != NULL) {
+        topOutBitmap = GFX->newBitmap(MATRIX_WIDTH, TOPOUT_CHUNK_ROWS * MATRIX_GRID_CELL_SIZE, kColorClear);
+
+        if (topOutBitmap != NULL) {
+            GFX->pushContext(topOutBitmap);
+            GFX->tileBitmap(bitmapAssets->column, 0, 0, MATRIX_WIDTH, TOPOUT_CHUNK_ROWS * MATRIX_GRID_CELL_SIZE, kBitmapUnflipped);
+            GFX->popContext();
+        }
+    }
+
+    if (gameOverBitmap == NULL) {
+        gameOverBitmap = GFX->newBitmap(GAMEOVER_WIDTH, LCD_ROWS, kColorBlack);
+
+        if (gameOverBitmap != NULL) {
+            int gameOverY = NEXT_BOX_Y + NEXT_BOX_HEIGHT;
+            int gameOverWidth = MATRIX_GRID_CELL_SIZE * 10;
+            int gameOverHeight = MATRIX_GRID_CELL_SIZE * 3;
+
+            int txtHeight = textHeight(GAMEOVER_FONT_SIZE);
+            int GaTxtWidth = textWidth("Ga", strlen("Ga"), GAMEOVER_FONT_SIZE);
+
+            int fullLengthWidth = textWidth("Gameer", strlen("Gameer"), GAMEOVER_FONT_SIZE);
+
+            // Positions are relative to the bitmap, which starts a cell left of the matrix
+            int txtX = MATRIX_GRID_CELL_SIZE + (gameOverWidth / 2) - (fullLengthWidth / 2);
+            int txtY = gameOverY + (gameOverHeight / 2) - (txtHeight * 2) / 2;
+
+            GFX->pushContext(gameOverBitmap);
+            textDraw("Game", txtX, txtY, GAMEOVER_FONT_SIZE, kColorWhite);
+            textDraw("Over", txtX + GaTxtWidth, txtY + txtHeight, GAMEOVER_FONT_SIZE, kColorWhite);
+            GFX->popContext();
+        }
+
+        for (int frame = 0; frame <= GAMEOVER_WIPE_FRAMES; frame++) {
+            double endPct = (double)frame / (double)GAMEOVER_WIPE_FRAMES;
+
+            gameOverWipeHeights[frame] = (int)(sin((endPct * 3.14159) / 2) * LCD_ROWS);
+        }
+    }
+}
+
+// Draws the locked cells of matrix rows [firstRow, lastRow] into the stack bitmap
+// Called when a piece locks or rows are removed. The screen is left as it is
+static void renderStack(const MatrixGrid matrix, int firstRow, int lastRow) {
+    if (stackBitmap == NULL) {
+        return;
+    }
+
+    if (blitterReady) {
+        int width = 0;
+        int height = 0;
+        int rowBytes = 0;
+        uint8_t* data = NULL;
+
+        GFX->getBitmapData(stackBitmap, &width, &height, &rowBytes, NULL, &data);
+        blitterDrawRows(&blitter, matrix, firstRow, lastRow, data, rowBytes);
+
+        return;
+    }
+
+    GFX->pushContext(stackBitmap);
+
+    // Runs of empty cells are filled with one call and runs of blocks from the same piece are tiled with one call
+    for (int row = firstRow; row <= lastRow; row++) {
+        int col = 0;
+
+        while (col < MATRIX_GRID_COLS) {
+            LCDBitmap* block = lockedBlockBitmap(&matrix[row][col]);
+            int runLength = 1;
+
+            while (col + runLength < MATRIX_GRID_COLS && lockedBlockBitmap(&matrix[row][col + runLength]) == block) {
+                runLength++;
+            }
+
+            int x = BLITTER_FIRST_BIT + (col * MATRIX_GRID_CELL_SIZE);
+            int y = MATRIX_GRID_TOP_Y(row);
+
+            if (block != NULL) {
+                GFX->tileBitmap(block, x, y, runLength * MATRIX_GRID_CELL_SIZE, MATRIX_GRID_CELL_SIZE, kBitmapUnflipped);
+            } else {
+                GFX->fillRect(x, y, runLength * MATRIX_GRID_CELL_SIZE, MATRIX_GRID_CELL_SIZE, kColorWhite);
+            }
+
+            drawCalls++;
+            col += runLength;
         }
     }
+
+    GFX->popContext();
+}
+
+// Bitmap for a cell in the stack bitmap, or NULL if it's drawn empty
+static LCDBitmap* lockedBlockBitmap(const MatrixCell* cell) {
+    if (cell->filled && !cell->player) {
+        return blockBitmapForPiece(cell->piece);
+    }
+
+    return NULL;
+}
+
+// Copies matrix rows [firstRow, lastRow] of the stack bitmap to the screen
+static void showStack(int firstRow, int lastRow) {
+    if (stackBitmap == NULL) {
+        return;
+    }
+
+    GFX->setClipRect(MATRIX_START_X, MATRIX_GRID_TOP_Y(firstRow), MATRIX_WIDTH, (lastRow - firstRow + 1) * MATRIX_GRID_CELL_SIZE);
+    GFX->drawBitmap(stackBitmap, BLITTER_BITMAP_X, 0, kBitmapUnflipped);
+    GFX->clearClipRect();
+    drawCalls++;
+}
+
+// Flashes completed rows on screen, or restores them if restore is true
+// The rows are inverted in the frame buffer when the blitter's available, else they're blanked
+static void flashCompletedRows(SceneState* state, bool restore) {
+    const CompletedRows* completed = &(state->roundCompletedRows);
+
+    if (state->rowsFlashed == !restore) {
+        return;
+    }
+
+    state->rowsFlashed = !restore;
+
+    for (int i = 0; i < completed->numRows; i++) {
+        int row = completed->rows[i];
+
+        if (blitterReady) {
+            blitterInvertRows(&blitter, row, row, GFX->getFrame() + (BLITTER_FIRST_WORD * 4), LCD_ROWSIZE);
+            GFX->markUpdatedRows(MATRIX_GRID_TOP_Y(row), MATRIX_GRID_TOP_Y(row) + MATRIX_GRID_CELL_SIZE - 1);
+        } else if (restore) {
+            showStack(row, row);
+        } else {
+            GFX->fillRect(MATRIX_START_X, MATRIX_GRID_TOP_Y(row), MATRIX_WIDTH, MATRIX_GRID_CELL_SIZE, kColorWhite);
+            drawCalls++;
+        }
+    }
+}
+
+// Takes completed rows out of the stack bitmap and the screen, after they've been removed from the matrix
+// Rows above are moved down in place, so only the rows left empty at the top need to be drawn
+static void collapseStack(const MatrixGrid matrix, const CompletedRows* completed) {
+    if (!blitterReady) {
+        renderStack(matrix, 0, MATRIX_GRID_ROWS - 1);
+        showStack(0, MATRIX_GRID_ROWS - 1);
+        return;
+    }
+
+    uint32_t removed = 0;
+    int lowestRow = 0;
+
+    for (int i = 0; i < completed->numRows; i++) {
+        removed |= 1u << completed->rows[i];
+        lowestRow = completed->rows[i] > lowestRow ? completed->rows[i] : lowestRow;
+    }
+
+    int width = 0;
+    int height = 0;
+    int rowBytes = 0;
+    uint8_t* data = NULL;
+    uint8_t* frame = GFX->getFrame() + (BLITTER_FIRST_WORD * 4);
+
+    GFX->getBitmapData(stackBitmap, &width, &height, &rowBytes, NULL, &data);
+
+    blitterRemoveRows(&blitter, removed, data, rowBytes);
+    blitterRemoveRows(&blitter, removed, frame, LCD_ROWSIZE);
+
+    // Draw the empty rows that came in at the top
+    blitterDrawRows(&blitter, matrix, 0, completed->numRows - 1, data, rowBytes);
+    blitterDrawRows(&blitter, matrix, 0, completed->numRows - 1, frame, LCD_ROWSIZE);
+
+    GFX->markUpdatedRows(0, MATRIX_GRID_TOP_Y(lowestRow) + MATRIX_GRID_CELL_SIZE - 1);
+}
+
+// Let groups of blocks that lost their support fall until they land on the floor or the stack
+// Groups are found with the bitboard, then the same moves are made in the matrix
+// Returns true if anything moved
+static bool cascadeStack(SceneState* state) {
+    Bitboard floating;
+    bool moved = false;
+
+    while (bitboardDropFloating(state->bitboard, floating)) {
+        matrixDropCells(state->matrix, floating);
+        moved = true;
+    }
+
+    if (moved) {
+        bitboardBuildColumns(state->bitboard, state->columns);
+
+        renderStack(state->matrix, 0, MATRIX_GRID_ROWS - 1);
+        showStack(0, MATRIX_GRID_ROWS - 1);
+    }
+
+    return moved;
+}
+
+// Draws the player piece at its position, over the ghost outline where it will land if showGhost is set
+// If previous is set, the area the piece covered there is restored from the stack bitmap first
+static void drawPlayerPiece(SceneState* state, const Position* previous, bool showGhost) {
+    if (stackBitmap == NULL) {
+        return;
+    }
+
+    Piece piece = state->playerPiece;
+    Position pos = state->playerPosition;
+
+    if (previous != NULL) {
+        restoreStackArea(*previous);
+    }
+
+    // The ghost is redrawn if it moved or if restoring the old piece area wiped part of it
+    if (showGhost) {
+        bool ghostMoved = !state->ghostShown
+            || previous == NULL
+            || state->ghostPosition.row != state->drawnGhostPosition.row
+            || state->ghostPosition.col != state->drawnGhostPosition.col
+            || state->ghostPosition.orientation != state->drawnGhostPosition.orientation;
+
+        if (ghostMoved && state->ghostShown) {
+            restoreStackArea(state->drawnGhostPosition);
+        }
+
+        if (ghostMoved || areasOverlap(*previous, state->ghostPosition)) {
+            LCDBitmap* ghostBitmap = ghostBitmaps[piece][state->ghostPosition.orientation];
+
+            if (ghostBitmap != NULL) {
+                GFX->drawBitmap(ghostBitmap, MATRIX_GRID_LEFT_X(state->ghostPosition.col), MATRIX_GRID_TOP_Y(state->ghostPosition.row), kBitmapUnflipped);
+                drawCalls++;
+            }
+
+            state->drawnGhostPosition = state->ghostPosition;
+            state->ghostShown = true;
+        }
+    }
+
+    LCDBitmap* bitmap = pieceBitmaps[piece][pos.orientation];
+
+    if (bitmap != NULL) {
+        GFX->drawBitmap(bitmap, MATRIX_GRID_LEFT_X(pos.col), MATRIX_GRID_TOP_Y(pos.row), kBitmapUnflipped);
+        drawCalls++;
+    }
+}
+
+// Copies the area a piece bitmap covers at the given position from the stack bitmap to the screen
+static void restoreStackArea(Position pos) {
+    // Keep within the matrix so the walls either side aren't drawn over
+    int left = MATRIX_GRID_LEFT_X(pos.col);
+    int top = MATRIX_GRID_TOP_Y(pos.row);
+    int right = left + PIECE_BITMAP_SIZE;
+    int bottom = top + PIECE_BITMAP_SIZE;
+
+    left = left < MATRIX_START_X ? MATRIX_START_X : left;
+    right = right > MATRIX_START_X + MATRIX_WIDTH ? MATRIX_START_X + MATRIX_WIDTH : right;
+    top = top < 0 ? 0 : top;
+    bottom = bottom > MATRIX_HEIGHT ? MATRIX_HEIGHT : bottom;
+
+    GFX->setClipRect(left, top, right - left, bottom - top);
+    GFX->drawBitmap(stackBitmap, BLITTER_BITMAP_X, 0, kBitmapUnflipped);
+    GFX->clearClipRect();
+    drawCalls++;
+}
+
+// Returns whether the areas piece bitmaps cover at two positions overlap
+static bool areasOverlap(Position a, Position b) {
+    return abs(a.col - b.col) < 4 && abs(a.row - b.row) < 4;
 }
 
 // Get reference to bitmap for a block used by a piece
@@ -919,69 +1861,44 @@ static LCDBitmap* blockBitmapForPiece(Piece piece) {
     return bitmap;
 }
 
-// Calculates what the difficulty should be for the given number of completed lines
-static int difficultyForLines(int initialDifficulty, int completedLines) {
-    // Round lines to lower 10
-    completedLines = (int)(floor(completedLines / 10) * 10);
+// Draws the level, score, lines, and next piece boxes that have changed since they were last drawn
+static void drawAllBoxes(SceneState* state) {
+    hudNumberUpdate(&state->scoreBox, &hudDigits, (unsigned int)state->score);
+    hudNumberUpdate(&state->levelBox, &hudDigits, (unsigned int)state->difficulty);
 
-    int difficulty = (completedLines / 10);
+    // The Lines and Seed boxes are under the CPU's board in versus mode
+    if (!state->versus) {
+        hudNumberUpdate(&state->linesBox, &hudDigits, (unsigned int)state->completedLines);
+        hudNumberUpdate(&state->seedBox, &hudDigits, state->seed);
+    }
 
-    return difficulty > initialDifficulty
-        ? difficulty
-        : initialDifficulty;
-}
+    // Update the previews whose piece changed. The first is shown in the Next box and the rest in the queue box
+    for (int i = 0; i < state->previewPieces; i++) {
+        Piece piece = state->previewQueue[i];
 
-// Get number of frames until gravity drops a piece one frame
-static inline int gravityFramesForDifficulty(int difficulty) {
-    if (difficulty < 0 || difficulty > MAX_DIFFICULTY) {
-        difficulty = MAX_DIFFICULTY;
-    }
+        if (piece != state->previewDrawn[i] && piece != None && previewBitmaps[piece] != NULL) {
+            int y = i == 0
+                ? NEXT_BOX_Y + ((NEXT_BOX_HEIGHT - PREVIEW_SLOT_HEIGHT) / 2)
+                : QUEUE_BOX_Y + ((i - 1) * PREVIEW_SLOT_HEIGHT);
 
-    return DIFFICULTY_LEVELS[difficulty];
+            GFX->drawBitmap(previewBitmaps[piece], i == 0 ? NEXT_BOX_X : QUEUE_BOX_X, y, kBitmapUnflipped);
+            state->previewDrawn[i] = piece;
+        }
+    }
 }
 
-// Draws the level, score, lines, and next piece boxes from current state
-static void drawAllBoxes(SceneState* state) {
-    // Update text boxes
-    char* scoreTxt;
-    char* levelTxt;
-    char* linesTxt;
-    char* seedTxt;
-
-    SYS->formatString(&scoreTxt, "%d", state->score);
-    SYS->formatString(&levelTxt, "%d", state->difficulty);
-    SYS->formatString(&linesTxt, "%d", state->completedLines);
-    SYS->formatString(&seedTxt, "%08X", state->seed);
-
-    drawBoxText(scoreTxt, SCORE_BOX_X, SCORE_BOX_Y, SCORE_BOX_WIDTH, SCORE_BOX_HEIGHT);
-    drawBoxText(levelTxt, LEVEL_BOX_X, LEVEL_BOX_Y, LEVEL_BOX_WIDTH, LEVEL_BOX_HEIGHT);
-    drawBoxText(linesTxt, LINES_BOX_X, LINES_BOX_Y, LINES_BOX_WIDTH, LINES_BOX_HEIGHT);
-    drawBoxText(seedTxt, SEED_BOX_X, SEED_BOX_Y, SEED_BOX_WIDTH, SEED_BOX_HEIGHT);
-
-    // Update piece displays in Next box
-    drawBoxPiece(state->standbyPiece, NEXT_BOX_X, NEXT_BOX_Y, NEXT_BOX_WIDTH, NEXT_BOX_HEIGHT);
-
-    SYS->realloc(scoreTxt, 0);
-    SYS->realloc(levelTxt, 0);
-    SYS->realloc(linesTxt, 0);
-    SYS->realloc(seedTxt, 0);
-}
+// Draw the rows of the CPU's board that changed since it was last shown
+static bool showCpuBoard(SceneState* state) {
+    BitboardRow rows[MATRIX_GRID_ROWS];
 
-// Draw a line of text within a bounded box.
-// Centers the text within the box width and height
-static void drawBoxText(const char* text, int x, int y, int width, int height) {
-    // Clear the box
-    GFX->fillRect(x, y, width, height, kColorWhite);
+    cpuDisplayRows(&state->cpu, rows);
 
-    textDrawCentered(text, x, y, width, height, DEFAULT_FONT_SIZE, kTextColorBlack);
+    return miniBoardUpdate(&state->miniBoard, rows);
 }
 
 // Draw a piece within a bounded box
 // Piece is centered within the box width and height
 static void drawBoxPiece(Piece piece, int x, int y, int width, int height) {
-    // Clear the box
-    GFX->fillRect(x, y, width, height, kColorWhite);
-
     LCDBitmap *block = blockBitmapForPiece(piece);
 
     if (block != NULL) {
@@ -1047,6 +1964,50 @@ static bool canSettlePiece(const MatrixGrid matrix, Piece piece, Position pos) {
     return shouldSettle;
 }
 
+// Step the CPU's game one frame and collect the garbage it sent
+// Topping out the CPU ends the player's game
+static bool updateCpu(SceneState* state) {
+    cpuStep(&state->cpu);
+    state->pendingGarbage += cpuTakeGarbage(&state->cpu);
+
+    bool screenUpdated = showCpuBoard(state);
+
+    if (cpuIsFinished(&state->cpu)) {
+        changeStatus(state, GameOver);
+    }
+
+    return screenUpdated;
+}
+
+// Add up to CPU_MAX_GARBAGE_PER_LOCK of the garbage lines sent by the CPU to the bottom of the matrix
+// Returns false if the stack was pushed off the top
+static bool addGarbage(SceneState* state) {
+    int numLines = state->pendingGarbage < CPU_MAX_GARBAGE_PER_LOCK ? state->pendingGarbage : CPU_MAX_GARBAGE_PER_LOCK;
+
+    state->pendingGarbage -= numLines;
+
+    int holeCol = rulesGarbageHoleCol(&state->garbageRng);
+
+    bool fits = matrixAddGarbageRows(state->matrix, numLines, holeCol, GARBAGE_PIECE);
+    bitboardAddGarbageRows(state->bitboard, numLines, holeCol);
+    bitboardBuildColumns(state->bitboard, state->columns);
+
+    // Every row moved up
+    renderStack(state->matrix, 0, MATRIX_GRID_ROWS - 1);
+    showStack(0, MATRIX_GRID_ROWS - 1);
+
+    return fits;
+}
+
+// Send garbage to the CPU for completed lines, less any garbage waiting to be added to the player's matrix
+static void sendGarbage(SceneState* state, int numLines) {
+    int garbage = rulesGarbageForLines(numLines);
+    int cancelled = garbage < state->pendingGarbage ? garbage : state->pendingGarbage;
+
+    state->pendingGarbage -= cancelled;
+    cpuReceiveGarbage(&state->cpu, garbage - cancelled);
+}
+
 
 // Retrieves the rows that have been completed by the player.
 static CompletedRows getCompletedRows(const MatrixGrid matrix) {
@@ -1064,7 +2025,8 @@ static CompletedRows getCompletedRows(const MatrixGrid matrix) {
             }
         }
         
-        if (completedCols == MATRIX_GRID_COLS) {
+        // A cascade can complete more than 4 rows at once. The rest are cleared after these
+        if (completedCols == MATRIX_GRID_COLS && completedRows.numRows < 4) {
             completedRows.rows[completedRows.numRows++] = row;
         }
     }
@@ -1089,7 +2051,7 @@ static void stopMusic() {
 
 // Returns if the background music is currently playing
 static bool isMusicPlaying() {
-    return SND->fileplayer->isPlaying(musicPlayer);
+    return musicPlayer != NULL && SND->fileplayer->isPlaying(musicPlayer);
 }
 
 // Play an audio sample
@@ -1105,18 +2067,6 @@ static void playSample(SceneState* state, AudioSample* sample) {
     }
 }
 
-// Increment score by an amount
-// Enforces max score restriction
-static int incrementScore(int current, int add){
-    int new = current + add;
-
-    if (new > MAX_SCORE) {
-        new = MAX_SCORE;
-    }
-
-    return new;
-}
-
 // Handle when the Music menu item toggles
 static void handleMusicMenu(void* userdata) {
     SceneState* state = (SceneState*)userdata;
@@ -1124,7 +2074,8 @@ static void handleMusicMenu(void* userdata) {
     if (state->musicMenuItem != NULL) {
         state->music = SYS->getMenuItemValue(state->musicMenuItem) == 1;
 
-        if (state->music) {
+        // Music picks up again when the board resumes
+        if (state->music && !state->suspended) {
             playMusic(state);
         } else {
             stopMusic();
@@ -1141,10 +2092,31 @@ static void handleSoundMenu(void* userdata) {
     }
 }
 
-// Handle when the End Game menu item is activated
+// Handle when the Pause menu item is activated
 // Gets passed the current scene state
-static void handleEndGameMenu(void* userdata) {
+static void handlePauseMenu(void* userdata) {
     SceneState* state = (SceneState*)userdata;
 
+    // Only a game in play can be paused, and not while a scene change is in progress
+    if (!state->suspended && state->status < TopOut && gameCanPushScene()) {
+        Scene* pauseScene = pauseSceneCreate(endGameHandler, state);
+
+        if (!gamePushScene(pauseScene)) {
+            pauseScene->destroy(pauseScene);
+        }
+    }
+}
+
+// Handle End Game from the pause overlay
+// Gets passed the board's scene state, which is resumed on the next frame
+static void endGameHandler(void* data) {
+    SceneState* state = (SceneState*)data;
+
+    // An abandoned game didn't end by the rules, so it isn't kept as a replay
+    if (state->replay != NULL) {
+        replayRecorderDiscard(state->replay);
+        state->replay = NULL;
+    }
+
     changeStatus(state, GameOver);
 }
\ No newline at end of file
@@ -3,7 +3,12 @@
 
 #include "scene.h"
 
+// Most upcoming pieces that can be previewed
+#define PREVIEW_MAX_PIECES 5
+
 // Create scene for Board scene
-Scene* boardSceneCreate(unsigned int seed, int initialDifficulty, bool music, bool sounds);
+// In versus mode the CPU plays its own board with the same seed and both boards send garbage lines to each other
+// In cascade mode blocks left floating by a line clear fall, which can complete more lines
+Scene* boardSceneCreate(unsigned int seed, int initialDifficulty, int previewPieces, bool ghost, bool music, bool sounds, bool versus, bool cascade);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include <limits.h>
+#include <string.h>
+#include "cpu.h"
+#include "rand.h"
+
+// Weights for scoring a placement. Fewer holes and a lower, flatter stack score higher
+#define CPU_WEIGHT_LINES 76
+#define CPU_WEIGHT_HEIGHT 51
+#define CPU_WEIGHT_HOLES 36
+#define CPU_WEIGHT_BUMPINESS 18
+
+static void changeStatus(CpuBoard* cpu, Status status);
+static void spawnPiece(CpuBoard* cpu);
+static void movePiece(CpuBoard* cpu);
+static void lockPiece(CpuBoard* cpu);
+static void clearLines(CpuBoard* cpu);
+static bool addGarbage(CpuBoard* cpu);
+static Position findPlacement(const CpuBoard* cpu);
+static int scorePlacement(const Bitboard board, Piece piece, Position pos);
+
+// Start a new game
+void cpuReset(CpuBoard* cpu, unsigned int seed, int initialDifficulty, bool cascade) {
+    bitboardClear(cpu->board);
+    bitboardBuildColumns(cpu->board, cpu->columns);
+
+    cpu->rng = seed;
+    cpu->garbageRng = rulesGarbageRngSeed(seed);
+
+    cpu->status = Start;
+    cpu->statusFrames = 0;
+    cpu->piece = None;
+    cpu->position = (Position){ .row = 0, .col = SPAWN_COL, .orientation = SPAWN_ORIENTATION };
+    cpu->target = cpu->position;
+    cpu->moveFrames = 0;
+    cpu->gravityFrames = 0;
+    cpu->completedRows = 0;
+    cpu->completedLines = 0;
+    cpu->pieces = 0;
+    cpu->initialDifficulty = initialDifficulty;
+    cpu->difficulty = initialDifficulty;
+    cpu->pendingGarbage = 0;
+    cpu->sentGarbage = 0;
+    cpu->cascade = cascade;
+}
+
+// Step one frame
+void cpuStep(CpuBoard* cpu) {
+    switch (cpu->status) {
+        case Start:
+            spawnPiece(cpu);
+            break;
+
+        case ARE:
+            if (++cpu->statusFrames >= ARE_FRAMES) {
+                changeStatus(cpu, Dropping);
+            }
+            break;
+
+        case Dropping:
+            movePiece(cpu);
+            break;
+
+        case LineClear:
+            if (cpu->statusFrames++ == LINECLEAR_FRAMES) {
+                clearLines(cpu);
+            }
+            break;
+
+        default:
+            // Pieces lock within Dropping, and nothing moves once the game has ended
+            break;
+    }
+}
+
+// Queue garbage lines for the next piece that locks without clearing lines
+void cpuReceiveGarbage(CpuBoard* cpu, int numLines) {
+    cpu->pendingGarbage += numLines;
+}
+
+// Take the garbage lines sent since the last call
+int cpuTakeGarbage(CpuBoard* cpu) {
+    int sent = cpu->sentGarbage;
+    cpu->sentGarbage = 0;
+
+    return sent;
+}
+
+// Copy the playfield with the current piece added
+void cpuDisplayRows(const CpuBoard* cpu, BitboardRow rows[MATRIX_GRID_ROWS]) {
+    if (cpu->piece != None && (cpu->status == ARE || cpu->status == Dropping)) {
+        Bitboard board;
+        memcpy(board, cpu->board, sizeof(Bitboard));
+        bitboardAddPiece(board, cpu->piece, cpu->position);
+
+        memcpy(rows, board, MATRIX_GRID_ROWS * sizeof(BitboardRow));
+    } else {
+        memcpy(rows, cpu->board, MATRIX_GRID_ROWS * sizeof(BitboardRow));
+    }
+}
+
+static void changeStatus(CpuBoard* cpu, Status status) {
+    cpu->status = status;
+    cpu->statusFrames = 0;
+}
+
+// Pick the next piece, same as the player's piece picker, and decide where it goes
+static void spawnPiece(CpuBoard* cpu) {
+    cpu->rng = rand_advance(cpu->rng);
+    cpu->piece = (Piece)(cpu->rng % 7);
+    cpu->position = (Position){ .row = 0, .col = SPAWN_COL, .orientation = SPAWN_ORIENTATION };
+    cpu->moveFrames = 0;
+    cpu->gravityFrames = 0;
+
+    if (!bitboardPieceFits(cpu->board, cpu->piece, cpu->position)) {
+        changeStatus(cpu, TopOut);
+        return;
+    }
+
+    cpu->target = findPlacement(cpu);
+
+    changeStatus(cpu, ARE);
+}
+
+// Rotate and shift the piece towards its target a step at a time while gravity pulls it down.
+// Once it's lined up it's soft dropped
+static void movePiece(CpuBoard* cpu) {
+    if (++cpu->moveFrames >= CPU_MOVE_FRAMES) {
+        Position next = cpu->position;
+        cpu->moveFrames = 0;
+
+        if (next.orientation != cpu->target.orientation) {
+            next.orientation = (next.orientation + 1) % 4;
+        } else if (next.col != cpu->target.col) {
+            next.col += next.col < cpu->target.col ? 1 : -1;
+        }
+
+        // A blocked move leaves the piece to fall where it is
+        if (bitboardPieceFits(cpu->board, cpu->piece, next)) {
+            cpu->position = next;
+        }
+    }
+
+    bool linedUp = cpu->position.orientation == cpu->target.orientation && cpu->position.col == cpu->target.col;
+
+    if (++cpu->gravityFrames >= (linedUp ? SOFTDROP_GRAVITY : rulesGravityFramesForDifficulty(cpu->difficulty))) {
+        cpu->gravityFrames = 0;
+
+        if (bitboardCanSettle(cpu->board, cpu->piece, cpu->position)) {
+            lockPiece(cpu);
+        } else {
+            cpu->position.row++;
+        }
+    }
+}
+
+// Add the piece to the playfield, then either clear lines or take on any garbage waiting
+static void lockPiece(CpuBoard* cpu) {
+    bitboardAddPiece(cpu->board, cpu->piece, cpu->position);
+    cpu->piece = None;
+    cpu->pieces++;
+
+    cpu->completedRows = bitboardCompletedRows(cpu->board);
+
+    if (cpu->completedRows != 0) {
+        changeStatus(cpu, LineClear);
+        return;
+    }
+
+    bool fits = addGarbage(cpu);
+    bitboardBuildColumns(cpu->board, cpu->columns);
+
+    changeStatus(cpu, fits ? Start : TopOut);
+}
+
+// Remove the completed rows and send garbage for them, less any garbage waiting to be added
+static void clearLines(CpuBoard* cpu) {
+    int numLines = __builtin_popcount(cpu->completedRows);
+
+    bitboardRemoveRows(cpu->board, cpu->completedRows);
+    bitboardBuildColumns(cpu->board, cpu->columns);
+
+    cpu->completedLines += numLines;
+    cpu->completedRows = 0;
+    cpu->difficulty = rulesDifficultyForLines(cpu->initialDifficulty, cpu->completedLines);
+
+    // A cascade can complete more than 4 rows at once, which is sent as a tetris
+    int garbage = rulesGarbageForLines(numLines < 4 ? numLines : 4);
+    int cancelled = garbage < cpu->pendingGarbage ? garbage : cpu->pendingGarbage;
+
+    cpu->pendingGarbage -= cancelled;
+    cpu->sentGarbage += garbage - cancelled;
+
+    // Loose blocks fall and any rows they complete are cleared as a chain
+    if (cpu->cascade) {
+        Bitboard floating;
+
+        while (bitboardDropFloating(cpu->board, floating)) {
+        }
+
+        bitboardBuildColumns(cpu->board, cpu->columns);
+        cpu->completedRows = bitboardCompletedRows(cpu->board);
+    }
+
+    changeStatus(cpu, cpu->completedRows != 0 ? LineClear : Start);
+}
+
+// Add waiting garbage lines to the bottom of the playfield
+// Returns false if the stack was pushed off the top
+static bool addGarbage(CpuBoard* cpu) {
+    int numLines = cpu->pendingGarbage < CPU_MAX_GARBAGE_PER_LOCK ? cpu->pendingGarbage : CPU_MAX_GARBAGE_PER_LOCK;
+
+    if (numLines == 0) {
+        return true;
+    }
+
+    cpu->pendingGarbage -= numLines;
+
+    return bitboardAddGarbageRows(cpu->board, numLines, rulesGarbageHoleCol(&cpu->garbageRng));
+}
+
+// Try every orientation in every column the piece can reach from where it spawned and keep the best landing spot
+// At most 4 * 12 drops, each found with the column copy of the playfield
+static Position findPlacement(const CpuBoard* cpu) {
+    Position best = cpu->position;
+    int bestScore = INT_MIN;
+
+    for (int orientation = 0; orientation < 4; orientation++) {
+        for (int col = -2; col < MATRIX_GRID_COLS; col++) {
+            Position pos = { .row = cpu->position.row, .col = col, .orientation = orientation };
+
+            if (!bitboardPieceFits(cpu->board, cpu->piece, pos)) {
+                continue;
+            }
+
+            Position dropped = bitboardColumnsDropPosition(cpu->columns, cpu->piece, pos);
+            int score = scorePlacement(cpu->board, cpu->piece, dropped);
+
+            if (score > bestScore) {
+                bestScore = score;
+                best = dropped;
+            }
+        }
+    }
+
+    return best;
+}
+
+// Score the playfield left after placing a piece
+static int scorePlacement(const Bitboard board, Piece piece, Position pos) {
+    Bitboard placed;
+    BitboardColumns columns;
+
+    memcpy(placed, board, sizeof(Bitboard));
+    bitboardAddPiece(placed, piece, pos);
+
+    uint32_t completed = bitboardCompletedRows(placed);
+
+    if (completed != 0) {
+        bitboardRemoveRows(placed, completed);
+    }
+
+    bitboardBuildColumns(placed, columns);
+
+    int totalHeight = 0;
+    int holes = 0;
+    int bumpiness = 0;
+    int previousHeight = -1;
+
+    for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+        // The lowest set bit is the top filled row, or the floor for an empty column
+        int height = MATRIX_GRID_ROWS - __builtin_ctz(columns[col]);
+        int filled = __builtin_popcount(columns[col]) - 1;
+
+        totalHeight += height;
+        holes += height - filled;
+
+        if (previousHeight >= 0) {
+            bumpiness += height > previousHeight ? height - previousHeight : previousHeight - height;
+        }
+
+        previousHeight = height;
+    }
+
+    return (CPU_WEIGHT_LINES * __builtin_popcount(completed))
+        - (CPU_WEIGHT_HEIGHT * totalHeight)
+        - (CPU_WEIGHT_HOLES * holes)
+        - (CPU_WEIGHT_BUMPINESS * bumpiness);
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef SCENES_BOARD_CPU_H
+#define SCENES_BOARD_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bitboard.h"
+#include "rules.h"
+
+// CPU opponent for versus mode.
+// Plays its own board with the same piece sequence as the player, using only the bitboard for collision
+// so both boards can be stepped every frame. Nothing in here may depend on the Playdate API.
+
+// Frames between each rotation or shift the CPU makes while lining up a piece
+#define CPU_MOVE_FRAMES 6
+
+// Most garbage lines added to a board when a piece locks. The rest wait for the next piece
+#define CPU_MAX_GARBAGE_PER_LOCK 4
+
+typedef struct CpuBoard {
+    Bitboard board;
+    BitboardColumns columns;
+
+    // RNG states for the piece picker, which matches the player's sequence, and for garbage holes
+    uint32_t rng;
+    uint32_t garbageRng;
+
+    Status status;
+    int statusFrames;
+
+    Piece piece;
+    Position position;
+
+    // Where the placement search decided to put the current piece
+    Position target;
+
+    int moveFrames;
+    int gravityFrames;
+
+    // Rows being cleared during LineClear (bit N is row N)
+    uint32_t completedRows;
+
+    int completedLines;
+    int pieces;
+
+    // Level the CPU started on and its current level, which rises with its own cleared lines like the player's
+    int initialDifficulty;
+    int difficulty;
+
+    // Garbage lines received and waiting to be added, and lines sent that the board scene hasn't taken yet
+    int pendingGarbage;
+    int sentGarbage;
+
+    // Whether blocks left floating by a line clear fall, as they do for the player
+    bool cascade;
+} CpuBoard;
+
+// Start a new game. The seed, starting level and cascade setting are the same ones the player's game uses
+void cpuReset(CpuBoard* cpu, unsigned int seed, int initialDifficulty, bool cascade);
+
+// Step one frame. Pieces fall at the gravity of the CPU's level, as they do for the player
+void cpuStep(CpuBoard* cpu);
+
+// Queue garbage lines to be added when the CPU's next piece locks without clearing any lines.
+// Lines the CPU clears cancel out queued garbage before any are sent back
+void cpuReceiveGarbage(CpuBoard* cpu, int numLines);
+
+// Take the garbage lines the CPU has sent since the last call
+int cpuTakeGarbage(CpuBoard* cpu);
+
+// Copy the playfield as it should be shown, with the current piece added
+void cpuDisplayRows(const CpuBoard* cpu, BitboardRow rows[MATRIX_GRID_ROWS]);
+
+// Returns whether the CPU's game has ended
+static inline bool cpuIsFinished(const CpuBoard* cpu) {
+    return cpu->status >= TopOut;
+}
+
+#endif
\ No newline at end of file
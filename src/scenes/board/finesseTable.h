@@ -0,0 +1,70 @@
+#ifndef SCENES_BOARD_FINESSETABLE_H
+#define SCENES_BOARD_FINESSETABLE_H
+
+#include <stdint.h>
+
+// Generated by pwb-finesse from the piece shapes in matrix.c. Regenerate rather than editing by hand
+//
+// Fewest inputs needed to move a piece from where it spawns to each orientation and column on an empty playfield.
+// Taps, rotations and holding left or right into the wall each count as one input
+
+// Added to a piece position's column to index the table, as positions can be left of the playfield
+#define FINESSE_COL_OFFSET 2
+#define FINESSE_COLS 12
+
+// The piece can't be at this orientation and column
+#define FINESSE_UNREACHABLE 0xFF
+
+static const uint8_t FINESSE_INPUTS[7][4][FINESSE_COLS] = {
+    // O
+    {
+        { 0xFF,    1,    2,    3,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    1,    2,    3,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    1,    2,    3,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    1,    2,    3,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF }
+    },
+    // I
+    {
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    1, 0xFF, 0xFF, 0xFF },
+        {    2,    2,    2,    3,    2,    1,    1,    2,    2,    2, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    1, 0xFF, 0xFF, 0xFF },
+        { 0xFF,    2,    2,    2,    3,    2,    1,    1,    2,    2,    2, 0xFF }
+    },
+    // S
+    {
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    2,    2,    3,    2,    1,    1,    2,    2,    2, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    2,    2,    3,    2,    1,    1,    2,    2,    2, 0xFF }
+    },
+    // Z
+    {
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    2,    2,    3,    2,    1,    1,    2,    2,    2, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    2,    2,    3,    2,    1,    1,    2,    2,    2, 0xFF }
+    },
+    // T
+    {
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    2,    2,    3,    3,    2,    1,    2,    3,    2, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    3,    4,    4,    3,    2,    3,    4,    3, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    2,    3,    3,    2,    1,    2,    3,    2,    2, 0xFF }
+    },
+    // L
+    {
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    2,    2,    3,    3,    2,    1,    2,    3,    2, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    3,    4,    4,    3,    2,    3,    4,    3, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    2,    3,    3,    2,    1,    2,    3,    2,    2, 0xFF }
+    },
+    // J
+    {
+        { 0xFF, 0xFF,    1,    2,    2,    1,    0,    1,    2,    1, 0xFF, 0xFF },
+        { 0xFF,    2,    2,    3,    3,    2,    1,    2,    3,    2, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    3,    4,    4,    3,    2,    3,    4,    3, 0xFF, 0xFF },
+        { 0xFF, 0xFF,    2,    3,    3,    2,    1,    2,    3,    2,    2, 0xFF }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "hud.h"
+#include "global.h"
+
+static const char DIGIT_CHARS[HUD_DIGIT_COUNT] = "0123456789ABCDEF";
+
+// Render the digits of a font into a bitmap table
+// Returns false if the table couldn't be created
+bool hudDigitsLoad(HudDigits* digits, LCDFont* font) {
+    digits->table = NULL;
+    digits->width = 0;
+    digits->height = 0;
+
+    if (font == NULL) {
+        return false;
+    }
+
+    // Every digit gets the width of the widest one so numbers can be laid out without measuring them
+    for (int i = 0; i < HUD_DIGIT_COUNT; i++) {
+        int width = GFX->getTextWidth(font, &DIGIT_CHARS[i], 1, kASCIIEncoding, 0);
+
+        if (width > digits->width) {
+            digits->width = width;
+        }
+    }
+
+    digits->height = GFX->getFontHeight(font);
+
+    if (digits->width <= 0 || digits->height <= 0) {
+        return false;
+    }
+
+    digits->table = GFX->newBitmapTable(HUD_DIGIT_COUNT, digits->width, digits->height);
+
+    if (digits->table == NULL) {
+        return false;
+    }
+
+    GFX->setFont(font);
+
+    for (int i = 0; i < HUD_DIGIT_COUNT; i++) {
+        LCDBitmap* bitmap = GFX->getTableBitmap(digits->table, i);
+
+        if (bitmap == NULL) {
+            hudDigitsFree(digits);
+            return false;
+        }
+
+        int width = GFX->getTextWidth(font, &DIGIT_CHARS[i], 1, kASCIIEncoding, 0);
+
+        GFX->pushContext(bitmap);
+        GFX->clear(kColorWhite);
+        GFX->setDrawMode(kDrawModeFillBlack);
+        GFX->drawText(&DIGIT_CHARS[i], 1, kASCIIEncoding, (digits->width - width) / 2, 0);
+        GFX->setDrawMode(kDrawModeCopy);
+        GFX->popContext();
+    }
+
+    return true;
+}
+
+// Free the bitmap table of the digits
+void hudDigitsFree(HudDigits* digits) {
+    if (digits->table != NULL) {
+        GFX->freeBitmapTable(digits->table);
+        digits->table = NULL;
+    }
+}
+
+// Setup a number box with nothing drawn yet
+void hudNumberInit(HudNumber* number, int x, int y, int width, int height, unsigned int base, int minDigits) {
+    number->x = x;
+    number->y = y;
+    number->width = width;
+    number->height = height;
+    number->base = base;
+    number->minDigits = minDigits;
+    number->value = 0;
+    number->drawn = false;
+}
+
+// Draw a number box if its value has changed since it was last drawn
+// Returns true if the box was drawn
+bool hudNumberUpdate(HudNumber* number, const HudDigits* digits, unsigned int value) {
+    if (number->drawn && number->value == value) {
+        return false;
+    }
+
+    // Split the value into digits, least significant first
+    int values[HUD_MAX_DIGITS];
+    int numDigits = 0;
+    unsigned int remaining = value;
+
+    do {
+        values[numDigits++] = (int)(remaining % number->base);
+        remaining /= number->base;
+    } while (remaining > 0 && numDigits < HUD_MAX_DIGITS);
+
+    while (numDigits < number->minDigits && numDigits < HUD_MAX_DIGITS) {
+        values[numDigits++] = 0;
+    }
+
+    // Clear the box
+    GFX->fillRect(number->x, number->y, number->width, number->height, kColorWhite);
+
+    int left = number->x + (number->width / 2) - ((numDigits * digits->width) / 2);
+    int top = number->y + (number->height / 2) - (digits->height / 2);
+
+    for (int i = 0; i < numDigits && digits->table != NULL; i++) {
+        LCDBitmap* bitmap = GFX->getTableBitmap(digits->table, values[numDigits - 1 - i]);
+
+        if (bitmap != NULL) {
+            GFX->drawBitmap(bitmap, left + (i * digits->width), top, kBitmapUnflipped);
+        }
+    }
+
+    number->value = value;
+    number->drawn = true;
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef SCENES_BOARD_HUD_H
+#define SCENES_BOARD_HUD_H
+
+#include <stdbool.h>
+#include "pd_api.h"
+
+// Numbers shown in the boxes around the matrix.
+// Digits are rendered once into a bitmap table and each box remembers the value it last drew,
+// so a box is only redrawn when its value changes and nothing is formatted or measured per update.
+
+// Hexadecimal digits are rendered so the seed can be shown too
+#define HUD_DIGIT_COUNT 16
+
+// Most digits a box can show
+#define HUD_MAX_DIGITS 10
+
+typedef struct HudDigits {
+    // One fixed-width bitmap per digit, black on white
+    LCDBitmapTable* table;
+    int width;
+    int height;
+} HudDigits;
+
+typedef struct HudNumber {
+    // Bounds of the box the number is centered in
+    int x;
+    int y;
+    int width;
+    int height;
+
+    unsigned int base;
+    // Numbers with fewer digits are padded with zeros
+    int minDigits;
+
+    // Value currently on screen. Only meaningful if drawn is set
+    unsigned int value;
+    bool drawn;
+} HudNumber;
+
+// Render the digits of a font into a bitmap table
+// Returns false if the table couldn't be created
+bool hudDigitsLoad(HudDigits* digits, LCDFont* font);
+
+// Free the bitmap table of the digits
+void hudDigitsFree(HudDigits* digits);
+
+// Setup a number box with nothing drawn yet
+void hudNumberInit(HudNumber* number, int x, int y, int width, int height, unsigned int base, int minDigits);
+
+// Draw a number box if its value has changed since it was last drawn
+// Returns true if the box was drawn
+bool hudNumberUpdate(HudNumber* number, const HudDigits* digits, unsigned int value);
+
+#endif
\ No newline at end of file
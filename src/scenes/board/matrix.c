@@ -262,6 +262,65 @@ void matrixRemoveRows(MatrixGrid matrix, int* rows, int totalRows) {
     }
 }
 
+// Push the matrix up and fill the bottom rows with garbage
+bool matrixAddGarbageRows(MatrixGrid matrix, int totalRows, int holeCol, Piece piece) {
+    bool fits = true;
+
+    if (totalRows > MATRIX_GRID_ROWS) {
+        totalRows = MATRIX_GRID_ROWS;
+    }
+
+    for (int row = 0; row < totalRows; row++) {
+        for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+            if (matrix[row][col].filled) {
+                fits = false;
+            }
+        }
+    }
+
+    for (int targetRow = 0; targetRow < MATRIX_GRID_ROWS - totalRows; targetRow++) {
+        int sourceRow = targetRow + totalRows;
+
+        for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+            matrix[targetRow][col].filled = matrix[sourceRow][col].filled;
+            matrix[targetRow][col].piece = matrix[sourceRow][col].piece;
+            matrix[targetRow][col].dirty = true;
+        }
+    }
+
+    for (int row = MATRIX_GRID_ROWS - totalRows; row < MATRIX_GRID_ROWS; row++) {
+        for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+            matrix[row][col].filled = col != holeCol;
+            matrix[row][col].piece = col != holeCol ? piece : None;
+            matrix[row][col].dirty = true;
+        }
+    }
+
+    return fits;
+}
+
+// Move the cells set in each row's mask down one row
+void matrixDropCells(MatrixGrid matrix, const uint16_t* rowMasks) {
+    // From the bottom up, so cells below have already moved out of the way
+    for (int row = MATRIX_GRID_ROWS - 2; row >= 0; row--) {
+        if (rowMasks[row] == 0) {
+            continue;
+        }
+
+        for (int col = 0; col < MATRIX_GRID_COLS; col++) {
+            if ((rowMasks[row] & (1 << col)) != 0) {
+                matrix[row + 1][col].filled = true;
+                matrix[row + 1][col].piece = matrix[row][col].piece;
+                matrix[row + 1][col].dirty = true;
+
+                matrix[row][col].filled = false;
+                matrix[row][col].piece = None;
+                matrix[row][col].dirty = true;
+            }
+        }
+    }
+}
+
 // Unsets the player attribute on all cells
 void matrixClearPlayerIndicator(MatrixGrid matrix) {
   for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
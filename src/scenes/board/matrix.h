@@ -2,6 +2,7 @@
 #define SCENES_BOARD_MATRIX_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define MATRIX_WIDTH 100
 #define MATRIX_HEIGHT LCD_ROWS
@@ -69,6 +70,14 @@ void matrixRemovePiecePoints(MatrixGrid matrix, const MatrixPiecePoints* points)
 // Remove specified rows from the matrix
 void matrixRemoveRows(MatrixGrid matrix, int* rows, int totalRows);
 
+// Push the matrix up and fill the bottom rows with blocks of the given piece, leaving one empty cell in each at holeCol
+// Returns false if filled cells were pushed off the top
+bool matrixAddGarbageRows(MatrixGrid matrix, int totalRows, int holeCol, Piece piece);
+
+// Move the cells set in each row's mask (bit N is column N) down one row
+// The cells they move into must be empty or moving too
+void matrixDropCells(MatrixGrid matrix, const uint16_t* rowMasks);
+
 // Returns whether or not the given X/Y points are are not already filled in the matrix
 // Current player piece points are ignored
 bool matrixPointsAvailable(const MatrixGrid matrix, const MatrixPiecePoints* points);
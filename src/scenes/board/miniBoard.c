@@ -0,0 +1,115 @@
+#include "miniBoard.h"
+#include "global.h"
+
+// Black pixels for each combination of 5 cells, 25 bits with the leftmost pixel in the highest bit.
+// A filled cell is a square one pixel smaller than the cell so neighbouring blocks stay apart
+static uint32_t halfPatterns[32];
+static bool halfPatternsBuilt = false;
+
+static void buildHalfPatterns(void) {
+    for (int cells = 0; cells < 32; cells++) {
+        uint32_t pattern = 0;
+
+        for (int col = 0; col < 5; col++) {
+            if ((cells & (1 << col)) != 0) {
+                pattern |= 0xFu << (21 - (col * MINI_BOARD_CELL_SIZE));
+            }
+        }
+
+        halfPatterns[cells] = pattern;
+    }
+
+    halfPatternsBuilt = true;
+}
+
+// Write the pixel rows of one playfield row. Set bits are white, same as the frame buffer
+static void packRow(uint8_t* data, int rowBytes, BitboardRow cells) {
+    uint64_t black = ((uint64_t)halfPatterns[cells & 0x1F] << 39) | ((uint64_t)halfPatterns[(cells >> 5) & 0x1F] << 14);
+    uint64_t line = ~black;
+    int bytes = rowBytes < 8 ? rowBytes : 8;
+
+    for (int y = 0; y < MINI_BOARD_CELL_SIZE; y++) {
+        uint8_t* pixels = data + (y * rowBytes);
+
+        for (int i = 0; i < bytes; i++) {
+            // The last pixel row of each cell is the gap to the row below
+            pixels[i] = y < MINI_BOARD_CELL_SIZE - 1 ? (uint8_t)(line >> (56 - (8 * i))) : 0xFF;
+        }
+    }
+}
+
+// Create the bitmap for a mini board
+bool miniBoardInit(MiniBoard* mini, int x, int y) {
+    if (!halfPatternsBuilt) {
+        buildHalfPatterns();
+    }
+
+    mini->bitmap = GFX->newBitmap(MINI_BOARD_WIDTH, MINI_BOARD_HEIGHT, kColorWhite);
+    mini->x = x;
+    mini->y = y;
+    mini->drawn = false;
+
+    return mini->bitmap != NULL;
+}
+
+// Draw every row on the next update
+void miniBoardInvalidate(MiniBoard* mini) {
+    mini->drawn = false;
+}
+
+// Draw the rows that changed since the last update
+bool miniBoardUpdate(MiniBoard* mini, const BitboardRow rows[MATRIX_GRID_ROWS]) {
+    if (mini->bitmap == NULL) {
+        return false;
+    }
+
+    int width = 0;
+    int height = 0;
+    int rowBytes = 0;
+    uint8_t* data = NULL;
+
+    GFX->getBitmapData(mini->bitmap, &width, &height, &rowBytes, NULL, &data);
+
+    if (data == NULL) {
+        return false;
+    }
+
+    int firstRow = -1;
+    int lastRow = -1;
+
+    for (int row = 0; row < MATRIX_GRID_ROWS; row++) {
+        if (mini->drawn && rows[row] == mini->rows[row]) {
+            continue;
+        }
+
+        packRow(data + (row * MINI_BOARD_CELL_SIZE * rowBytes), rowBytes, rows[row]);
+        mini->rows[row] = rows[row];
+
+        if (firstRow < 0) {
+            firstRow = row;
+        }
+
+        lastRow = row;
+    }
+
+    mini->drawn = true;
+
+    if (firstRow < 0) {
+        return false;
+    }
+
+    // Only the rows that changed are copied to the screen
+    GFX->setClipRect(mini->x, mini->y + (firstRow * MINI_BOARD_CELL_SIZE), MINI_BOARD_WIDTH, (lastRow - firstRow + 1) * MINI_BOARD_CELL_SIZE);
+    GFX->drawBitmap(mini->bitmap, mini->x, mini->y, kBitmapUnflipped);
+    GFX->clearClipRect();
+
+    return true;
+}
+
+// Free the bitmap of a mini board
+void miniBoardFree(MiniBoard* mini) {
+    if (mini->bitmap != NULL) {
+        GFX->freeBitmap(mini->bitmap);
+        mini->bitmap = NULL;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef SCENES_BOARD_MINIBOARD_H
+#define SCENES_BOARD_MINIBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pd_api.h"
+#include "bitboard.h"
+
+// Half-size view of a playfield, used to show the CPU's board in versus mode.
+// Cells are MINI_BOARD_CELL_SIZE pixels square and each pixel row is packed straight from a bitboard row
+// into the bitmap data. Only rows that changed since the last update are packed and drawn.
+
+#define MINI_BOARD_CELL_SIZE 5
+#define MINI_BOARD_WIDTH (MATRIX_GRID_COLS * MINI_BOARD_CELL_SIZE)
+#define MINI_BOARD_HEIGHT (MATRIX_GRID_ROWS * MINI_BOARD_CELL_SIZE)
+
+typedef struct MiniBoard {
+    LCDBitmap* bitmap;
+
+    // Screen position of the top left cell
+    int x;
+    int y;
+
+    // Rows currently in the bitmap and on screen. Only meaningful if drawn is set
+    BitboardRow rows[MATRIX_GRID_ROWS];
+    bool drawn;
+} MiniBoard;
+
+// Create the bitmap for a mini board drawn at the given position
+// Returns false if the bitmap can't be created, in which case updates draw nothing
+bool miniBoardInit(MiniBoard* mini, int x, int y);
+
+// Draw every row on the next update, such as after the screen behind the board was drawn over
+void miniBoardInvalidate(MiniBoard* mini);
+
+// Draw the rows that changed since the last update
+// Returns true if anything was drawn
+bool miniBoardUpdate(MiniBoard* mini, const BitboardRow rows[MATRIX_GRID_ROWS]);
+
+// Free the bitmap of a mini board
+void miniBoardFree(MiniBoard* mini);
+
+#endif
\ No newline at end of file
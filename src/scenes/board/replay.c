@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include "replay.h"
+#include "global.h"
+
+// Number of suffixes tried when another replay already has the same seed and start time
+#define REPLAY_NAME_ATTEMPTS 100
+
+// Write out buffered frames
+static void flushFrames(ReplayRecorder* recorder) {
+    if (recorder->buffered > 0) {
+        if (pd->file->write(recorder->file, recorder->buffer, recorder->buffered * sizeof(ReplayFrame)) < 0) {
+            SYS->logToConsole("Error writing replay '%s': %s", recorder->path, pd->file->geterr());
+            recorder->failed = true;
+        }
+
+        recorder->buffered = 0;
+    }
+}
+
+// Start recording a game to a new file in the replays directory
+// Returns NULL if the file can't be created
+ReplayRecorder* replayRecorderCreate(unsigned int seed, int initialDifficulty, uint16_t flags) {
+    ReplayRecorder* recorder = SYS->realloc(NULL, sizeof(ReplayRecorder));
+
+    if (recorder == NULL) {
+        return NULL;
+    }
+
+    pd->file->mkdir(REPLAY_DIRECTORY);
+
+    // Games on the same seed started within a second would share a name, so add a counter rather than truncate the earlier file
+    unsigned int started = SYS->getSecondsSinceEpoch(NULL);
+    FileStat stat;
+
+    snprintf(recorder->path, REPLAY_PATH_LENGTH, REPLAY_DIRECTORY "/%08X-%u" REPLAY_EXTENSION, seed, started);
+
+    for (int attempt = 1; attempt < REPLAY_NAME_ATTEMPTS && pd->file->stat(recorder->path, &stat) == 0; attempt++) {
+        snprintf(recorder->path, REPLAY_PATH_LENGTH, REPLAY_DIRECTORY "/%08X-%u-%d" REPLAY_EXTENSION, seed, started, attempt);
+    }
+
+    if (pd->file->stat(recorder->path, &stat) == 0) {
+        SYS->logToConsole("Error creating replay '%s': file already exists", recorder->path);
+        SYS->realloc(recorder, 0);
+
+        return NULL;
+    }
+
+    recorder->file = pd->file->open(recorder->path, kFileWrite);
+
+    if (recorder->file == NULL) {
+        SYS->logToConsole("Error creating replay '%s': %s", recorder->path, pd->file->geterr());
+        SYS->realloc(recorder, 0);
+
+        return NULL;
+    }
+
+    recorder->buffered = 0;
+    recorder->failed = false;
+
+    recorder->header = (ReplayHeader){
+        .magic = REPLAY_MAGIC,
+        .version = REPLAY_VERSION,
+        .flags = flags,
+        .seed = seed,
+        .initialDifficulty = initialDifficulty,
+        .numFrames = 0
+    };
+
+    // Reserve room for the header. It's rewritten with the results once the game ends
+    if (pd->file->write(recorder->file, &recorder->header, sizeof(ReplayHeader)) < 0) {
+        SYS->logToConsole("Error writing replay '%s': %s", recorder->path, pd->file->geterr());
+        replayRecorderDiscard(recorder);
+
+        return NULL;
+    }
+
+    return recorder;
+}
+
+// Record the buttons for a frame
+void replayRecorderAddFrame(ReplayRecorder* recorder, PDButtons current, PDButtons pushed) {
+    recorder->buffer[recorder->buffered].current = (uint8_t)current;
+    recorder->buffer[recorder->buffered].pushed = (uint8_t)pushed;
+    recorder->header.numFrames++;
+
+    if (++recorder->buffered == REPLAY_BUFFER_FRAMES) {
+        flushFrames(recorder);
+    }
+}
+
+// Record the results of the game and close the file. The recorder is deallocated
+void replayRecorderFinish(ReplayRecorder* recorder, int score, int completedLines, int difficulty, int pieces, int finesseFaults) {
+    flushFrames(recorder);
+
+    // The header would count frames that aren't in the file
+    if (recorder->failed) {
+        replayRecorderDiscard(recorder);
+        return;
+    }
+
+    recorder->header.score = score;
+    recorder->header.completedLines = completedLines;
+    recorder->header.difficulty = difficulty;
+    recorder->header.pieces = pieces;
+    recorder->header.finesseFaults = finesseFaults;
+
+    pd->file->seek(recorder->file, 0, SEEK_SET);
+
+    // Without its results the header would still claim zero frames, so don't keep a file that can't be played back
+    if (pd->file->write(recorder->file, &recorder->header, sizeof(ReplayHeader)) < 0) {
+        SYS->logToConsole("Error writing replay '%s': %s", recorder->path, pd->file->geterr());
+        replayRecorderDiscard(recorder);
+
+        return;
+    }
+
+    pd->file->close(recorder->file);
+
+    SYS->logToConsole("Saved replay '%s' (%u frames)", recorder->path, recorder->header.numFrames);
+
+    SYS->realloc(recorder, 0);
+}
+
+// Stop recording without finishing the game. The incomplete file is deleted and the recorder is deallocated
+void replayRecorderDiscard(ReplayRecorder* recorder) {
+    pd->file->close(recorder->file);
+    pd->file->unlink(recorder->path, 0);
+
+    SYS->realloc(recorder, 0);
+}
\ No newline at end of file
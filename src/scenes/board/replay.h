@@ -0,0 +1,40 @@
+#ifndef SCENES_BOARD_REPLAY_H
+#define SCENES_BOARD_REPLAY_H
+
+#include "pd_api.h"
+#include "replayFormat.h"
+
+// Number of frames held in memory before they're written to the replay file
+#define REPLAY_BUFFER_FRAMES 1024
+
+#define REPLAY_PATH_LENGTH 48
+
+// Streams the buttons of a game to a replay file
+typedef struct ReplayRecorder {
+    SDFile* file;
+    char path[REPLAY_PATH_LENGTH];
+    ReplayHeader header;
+
+    ReplayFrame buffer[REPLAY_BUFFER_FRAMES];
+    int buffered;
+
+    // Set when frames couldn't be written. The replay is discarded rather than saved with frames missing
+    bool failed;
+} ReplayRecorder;
+
+// Start recording a game to a new file in the replays directory
+// flags holds the REPLAY_FLAG_ rule variations the game is played with
+// Returns NULL if the file can't be created
+ReplayRecorder* replayRecorderCreate(unsigned int seed, int initialDifficulty, uint16_t flags);
+
+// Record the buttons for a frame
+void replayRecorderAddFrame(ReplayRecorder* recorder, PDButtons current, PDButtons pushed);
+
+// Record the results of the game and close the file. The recorder is deallocated
+// The file is deleted instead if any frames couldn't be written
+void replayRecorderFinish(ReplayRecorder* recorder, int score, int completedLines, int difficulty, int pieces, int finesseFaults);
+
+// Stop recording without finishing the game. The incomplete file is deleted and the recorder is deallocated
+void replayRecorderDiscard(ReplayRecorder* recorder);
+
+#endif
\ No newline at end of file
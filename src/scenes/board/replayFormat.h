@@ -0,0 +1,52 @@
+#ifndef SCENES_BOARD_REPLAYFORMAT_H
+#define SCENES_BOARD_REPLAYFORMAT_H
+
+#include <stdint.h>
+
+// Layout of recorded games, shared by the board scene and the host tools.
+// A file is a ReplayHeader followed by one ReplayFrame for every frame the game was played.
+// Nothing in here may depend on the Playdate API.
+
+#define REPLAY_MAGIC 0x52425750 // "PWBR"
+#define REPLAY_VERSION 1
+
+// Directory in the game's data folder that replays are saved to
+#define REPLAY_DIRECTORY "replays"
+#define REPLAY_EXTENSION ".pwbr"
+
+// Rule variations, set in ReplayHeader.flags
+// Played against the CPU, with garbage lines sent between the boards
+#define REPLAY_FLAG_VERSUS 0x0001
+// Blocks left floating by a line clear fall, and can complete more lines
+#define REPLAY_FLAG_CASCADE 0x0002
+
+typedef struct ReplayHeader {
+    uint32_t magic;
+    uint16_t version;
+
+    // Rule variations the game was played with. Zero for the standard rules
+    uint16_t flags;
+
+    uint32_t seed;
+    uint32_t initialDifficulty;
+    uint32_t numFrames;
+
+    // Results at the end of the game
+    uint32_t score;
+    uint32_t completedLines;
+    uint32_t difficulty;
+    uint32_t pieces;
+
+    // Pieces that took more inputs than the finesse table allows. Zero in replays saved before it was counted
+    uint32_t finesseFaults;
+
+    uint32_t reserved[6];
+} ReplayHeader;
+
+// Buttons for one frame, as returned by getButtonState
+typedef struct ReplayFrame {
+    uint8_t current;
+    uint8_t pushed;
+} ReplayFrame;
+
+#endif
\ No newline at end of file
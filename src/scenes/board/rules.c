@@ -0,0 +1,109 @@
+#include "rules.h"
+#include "matrix.h"
+#include "rand.h"
+
+// Mixed into the seed for the garbage hole RNGs, so holes don't follow the piece sequence
+#define GARBAGE_RNG_SEED 0x5A5A5A5A
+
+// Score is calculated based on the number of lines completed in one drop & the current difficulty
+static int SCORING[4] = {
+    40,
+    100,
+    300,
+    1200
+};
+
+// Garbage lines sent to the opponent for completing 1 to 4 lines in one drop
+static int GARBAGE[4] = {
+    0,
+    1,
+    2,
+    4
+};
+
+// How many frames per row a piece drops from gravity
+static int DIFFICULTY_LEVELS[21] = {
+    44,
+    41,
+    37,
+    34,
+    31,
+    27,
+    23,
+    18,
+    14,
+    9,
+    8,
+    7,
+    7,
+    6,
+    5,
+    5,
+    4,
+    4,
+    3,
+    3,
+    2
+};
+
+// Calculates what the difficulty should be for the given number of completed lines
+int rulesDifficultyForLines(int initialDifficulty, int completedLines) {
+    // Every 10 lines bumps the difficulty
+    int difficulty = (completedLines / 10);
+
+    return difficulty > initialDifficulty
+        ? difficulty
+        : initialDifficulty;
+}
+
+// Get number of frames until gravity drops a piece one row
+int rulesGravityFramesForDifficulty(int difficulty) {
+    if (difficulty < 0 || difficulty > MAX_DIFFICULTY) {
+        difficulty = MAX_DIFFICULTY;
+    }
+
+    return DIFFICULTY_LEVELS[difficulty];
+}
+
+// Points awarded for completing a number of lines in one drop at the given difficulty
+int rulesScoreForLines(int numLines, int difficulty) {
+    if (numLines < 1 || numLines > 4) {
+        return 0;
+    }
+
+    return SCORING[numLines - 1] * (difficulty + 1);
+}
+
+// Garbage lines sent to the opponent in versus mode for completing a number of lines in one drop
+int rulesGarbageForLines(int numLines) {
+    if (numLines < 1 || numLines > 4) {
+        return 0;
+    }
+
+    return GARBAGE[numLines - 1];
+}
+
+// Start the RNG that picks garbage holes for a board
+uint32_t rulesGarbageRngSeed(unsigned int seed) {
+    return seed ^ GARBAGE_RNG_SEED;
+}
+
+// Advance a garbage hole RNG and pick the column of the hole in the next garbage lines
+int rulesGarbageHoleCol(uint32_t* rng) {
+    *rng = rand_advance(*rng);
+
+    // The low bits of the RNG repeat quickly
+    return (int)((*rng >> 16) % MATRIX_GRID_COLS);
+}
+
+// Increment score by an amount
+// Enforces max score restriction
+int rulesIncrementScore(int current, int add) {
+    int new = current + add;
+
+    if (new > MAX_SCORE) {
+        new = MAX_SCORE;
+    }
+
+    return new;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef SCENES_BOARD_RULES_H
+#define SCENES_BOARD_RULES_H
+
+// Game rules shared by the board scene and the host simulation tools.
+// Nothing in here may depend on the Playdate API.
+
+#include <stdint.h>
+
+#define MAX_DIFFICULTY 20
+
+#define DAS_CHARGE_DELAY 19
+#define DAS_REPEAT_DELAY 7
+
+#define SOFTDROP_GRAVITY 2
+
+// Limit score to 999,999
+#define MAX_SCORE 999999
+
+#define ARE_FRAMES 2
+#define LINECLEAR_FRAMES 77
+#define TOPOUT_FRAMES 45
+
+// Column & orientation every piece spawns with
+#define SPAWN_COL 4
+#define SPAWN_ORIENTATION 0
+
+typedef enum Status {
+    // Lasts 1 frame, piece(s) are selected and the active piece is placed at the top of the screen
+    Start,
+
+    // Lasts 2 frames where the active piece is idle at the top of the screen
+    ARE,
+
+    // Piece is dropping and the player has control
+    Dropping,
+
+    // Piece has settled into a spot
+    Settled,
+
+    // Player has completed at least one line that needs cleared out
+    LineClear,
+
+    // Player has reached the top and the game must end
+    // Fills play area with blocks
+    // Lasts 45 frames then switches to GameOver state
+    TopOut,
+
+    // Display game over text and buttons for restarting game
+    GameOver
+} Status;
+
+// Calculates what the difficulty should be for the given number of completed lines
+int rulesDifficultyForLines(int initialDifficulty, int completedLines);
+
+// Get number of frames until gravity drops a piece one row
+int rulesGravityFramesForDifficulty(int difficulty);
+
+// Points awarded for completing a number of lines in one drop at the given difficulty
+int rulesScoreForLines(int numLines, int difficulty);
+
+// Garbage lines sent to the opponent in versus mode for completing a number of lines in one drop
+int rulesGarbageForLines(int numLines);
+
+// Start the RNG that picks garbage holes for a board. Every board in a game starts from the same seed,
+// so all of them get holes in the same columns
+uint32_t rulesGarbageRngSeed(unsigned int seed);
+
+// Advance a garbage hole RNG and pick the column of the hole in the next garbage lines
+int rulesGarbageHoleCol(uint32_t* rng);
+
+// Increment score by an amount
+// Enforces max score restriction
+int rulesIncrementScore(int current, int add);
+
+#endif
\ No newline at end of file
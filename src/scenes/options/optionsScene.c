@@ -7,11 +7,17 @@
 #include "rand.h"
 #include "text.h"
 
+#define OPTIONS_FONT_SIZE 14
+
 typedef struct FormValues {
     char seed[FORM_SEED_FIELD_LENGTH + 1];
     int difficulty;
+    int previewPieces;
+    bool ghost;
     bool music;
     bool sounds;
+    bool versus;
+    bool cascade;
 } FormValues;
 
 typedef struct OptionsState {
@@ -22,6 +28,9 @@ typedef struct OptionsState {
     int frameCountPerSecond;
 
     bool transitionToGame;
+
+    // Set once the board scene has been created. The form no longer takes input, since changes wouldn't be used
+    bool gameStarted;
 } OptionsState;
 
 // Handle start button press
@@ -32,8 +41,24 @@ static void submitHandler(void* data) {
     state->transitionToGame = true;
 }
 
+// Every field uses the same font
+static const int fontSizes[] = { OPTIONS_FONT_SIZE };
+
+// Called while the previous scene is still running
+static bool prefetchScene(Scene* scene) {
+    (void)scene;
+
+    textPreloadFonts(fontSizes, 1);
+
+    return true;
+}
+
 // Called on first frame when scene switches
 static void initScene(Scene* scene) {
+    // Sizes only used by other scenes are freed
+    textFreeFontsExcept(fontSizes, 1);
+    textPreloadFonts(fontSizes, 1);
+
     // Screen uses an black background
     GFX->fillRect(0, 0, LCD_COLUMNS, LCD_ROWS, kColorBlack);
 }
@@ -42,9 +67,12 @@ static void initScene(Scene* scene) {
 static bool updateScene(Scene* scene) {
     OptionsState* state = (OptionsState*)scene->data;
 
+    bool screenUpdated = false;
+
     // Once Start is pressed, transition to board scene
     if (state->transitionToGame) {
         state->transitionToGame = false;
+        state->gameStarted = true;
 
         // Convert seed hex value to int
         unsigned int seed = (unsigned int)strtoul(state->formValues->seed, NULL, 16);
@@ -52,19 +80,23 @@ static bool updateScene(Scene* scene) {
         Scene* boardScene = boardSceneCreate(
             seed, 
             state->formValues->difficulty, 
+            state->formValues->previewPieces,
+            state->formValues->ghost,
             state->formValues->music, 
-            state->formValues->sounds
+            state->formValues->sounds,
+            state->formValues->versus,
+            state->formValues->cascade
         );
 
         gameChangeScene(boardScene);
-    } else {
-        // Draw form
+    } else if (!state->gameStarted) {
+        // Draw fields that changed
         if (state->form != NULL) {
-            formUpdate(state->form);
+            screenUpdated = formUpdate(state->form);
         }
     }
 
-    return true;
+    return screenUpdated;
 }
 
 static void destroyScene(Scene* scene) {
@@ -110,8 +142,14 @@ Scene* optionsSceneCreate(bool music, bool sounds) {
 
     scene->name = "Options Screen";
     scene->init = initScene;
+    scene->prefetch = prefetchScene;
     scene->update = updateScene;
     scene->destroy = destroyScene;
+    scene->suspend = NULL;
+    scene->resume = NULL;
+    scene->handleEvent = NULL;
+    scene->footprint = NULL;
+    scene->refreshRate = MENU_FPS;
 
     OptionsState* state = SYS->realloc(NULL, sizeof(OptionsState));
     scene->data = (void*)state;
@@ -120,27 +158,34 @@ Scene* optionsSceneCreate(bool music, bool sounds) {
 
     FormValues *values = SYS->realloc(NULL, sizeof(FormValues));
     values->difficulty = 0;
+    values->previewPieces = 1;
+    values->ghost = false;
     values->music = music;
     values->sounds = sounds;
+    values->versus = false;
+    values->cascade = false;
 
     generateSeed(values->seed);
 
     state->form = formCreate();
     state->formValues = values;
 
-    formAddField(state->form, formCreateSeedField((Dimensions){ .x = 75, .y = 54, .width = 140, .height = 30 }, "Seed", values->seed, 14, 14));
-    formAddField(state->form, formCreateNumericalField((Dimensions){ .x = 245, .y = 54, .width = 80, .height = 30 }, "Level", &values->difficulty, 0, 20, 14, 14));
-
-    formAddField(state->form, formCreateBooleanField((Dimensions){ .x = 75, .y = 114, .width = 80, .height = 30 }, "Music", &values->music, 14, 14));
-    formAddField(state->form, formCreateBooleanField((Dimensions) { .x = 245, .y = 114, .width = 80, .height = 30 }, "SFX", &values->sounds, 14, 14));
+    formAddField(state->form, formCreateSeedField((Dimensions){ .x = 15, .y = 54, .width = 140, .height = 30 }, "Seed", values->seed, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
+    formAddField(state->form, formCreateNumericalField((Dimensions){ .x = 165, .y = 54, .width = 70, .height = 30 }, "Level", &values->difficulty, 0, 20, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
+    formAddField(state->form, formCreateBooleanField((Dimensions){ .x = 245, .y = 54, .width = 70, .height = 30 }, "Ghost", &values->ghost, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
+    formAddField(state->form, formCreateBooleanField((Dimensions){ .x = 325, .y = 54, .width = 70, .height = 30 }, "Cascade", &values->cascade, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
 
-    FormField* submitBtn = formCreateButtonField((Dimensions) { .x = (LCD_COLUMNS - 140) / 2, .y = 174, .width = 140, .height = 30 }, "Play!", 14, 14, state, submitHandler);
+    formAddField(state->form, formCreateBooleanField((Dimensions){ .x = 15, .y = 114, .width = 80, .height = 30 }, "Music", &values->music, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
+    formAddField(state->form, formCreateNumericalField((Dimensions){ .x = 110, .y = 114, .width = 80, .height = 30 }, "Next", &values->previewPieces, 1, PREVIEW_MAX_PIECES, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
+    formAddField(state->form, formCreateBooleanField((Dimensions) { .x = 205, .y = 114, .width = 80, .height = 30 }, "SFX", &values->sounds, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
+    formAddField(state->form, formCreateBooleanField((Dimensions) { .x = 300, .y = 114, .width = 80, .height = 30 }, "CPU", &values->versus, OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE));
 
-    formAddField(state->form, submitBtn);
+    FormField* submitBtn = formCreateButtonField((Dimensions) { .x = (LCD_COLUMNS - 140) / 2, .y = 174, .width = 140, .height = 30 }, "Play!", OPTIONS_FONT_SIZE, OPTIONS_FONT_SIZE, state, submitHandler);
 
-    formFocus(state->form, submitBtn);
+    formFocus(state->form, formAddField(state->form, submitBtn));
 
     state->transitionToGame = false;
+    state->gameStarted = false;
     
     return scene;
 }
\ No newline at end of file
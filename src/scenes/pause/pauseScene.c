@@ -0,0 +1,131 @@
+#include "pauseScene.h"
+#include "global.h"
+#include "scene.h"
+#include "form.h"
+#include "game.h"
+#include "text.h"
+
+// Uses a font the board keeps loaded, so nothing is loaded or freed while paused
+#define PAUSE_FONT_SIZE 12
+
+#define PANEL_WIDTH 160
+#define PANEL_HEIGHT 124
+#define PANEL_X ((LCD_COLUMNS - PANEL_WIDTH) / 2)
+#define PANEL_Y ((LCD_ROWS - PANEL_HEIGHT) / 2)
+
+#define BUTTON_WIDTH 120
+#define BUTTON_HEIGHT 25
+#define BUTTON_X (PANEL_X + ((PANEL_WIDTH - BUTTON_WIDTH) / 2))
+#define BUTTON_Y (PANEL_Y + 44)
+
+typedef struct PauseState {
+    Form* form;
+
+    PauseSceneEndGameHandler endGameHandler;
+    void* endGameData;
+
+    bool resumeRequested;
+    bool endGameRequested;
+} PauseState;
+
+// Handle Resume button
+static void resumeHandler(void* data) {
+    PauseState* state = (PauseState*)data;
+
+    state->resumeRequested = true;
+}
+
+// Handle End Game button
+static void endGameHandler(void* data) {
+    PauseState* state = (PauseState*)data;
+
+    state->endGameRequested = true;
+}
+
+// Called on first frame when scene is pushed
+// The scene underneath is left on screen around the panel
+static void initScene(Scene* scene) {
+    (void)scene;
+
+    GFX->fillRect(PANEL_X, PANEL_Y, PANEL_WIDTH, PANEL_HEIGHT, kColorBlack);
+    GFX->drawRect(PANEL_X + 2, PANEL_Y + 2, PANEL_WIDTH - 4, PANEL_HEIGHT - 4, kColorWhite);
+
+    textDrawCentered("Paused", PANEL_X, PANEL_Y + 12, PANEL_WIDTH, textHeight(PAUSE_FONT_SIZE), PAUSE_FONT_SIZE, kColorWhite);
+}
+
+// Called on every frame
+static bool updateScene(Scene* scene) {
+    PauseState* state = (PauseState*)scene->data;
+    PDButtons released;
+
+    SYS->getButtonState(NULL, NULL, &released);
+
+    // B is a shortcut for Resume
+    if ((released & kButtonB) == kButtonB) {
+        state->resumeRequested = true;
+    }
+
+    if (state->endGameRequested) {
+        state->endGameRequested = false;
+
+        gamePopScene();
+
+        if (state->endGameHandler != NULL) {
+            state->endGameHandler(state->endGameData);
+        }
+
+        return false;
+    } else if (state->resumeRequested) {
+        state->resumeRequested = false;
+
+        gamePopScene();
+
+        return false;
+    }
+
+    return formUpdate(state->form);
+}
+
+// Called when the scene is popped
+// The screen is left for the resumed scene to redraw
+static void destroyScene(Scene* scene) {
+    PauseState* state = (PauseState*)scene->data;
+
+    formDestroy(state->form);
+
+    // Dispose of scene
+    SYS->realloc(scene->data, 0);
+    SYS->realloc(scene, 0);
+}
+
+// Create scene for the Pause overlay
+Scene* pauseSceneCreate(PauseSceneEndGameHandler endGameHandler, void* data) {
+    Scene* scene = SYS->realloc(NULL, sizeof(Scene));
+
+    scene->name = "Pause";
+    scene->init = initScene;
+    scene->prefetch = NULL;
+    scene->update = updateScene;
+    scene->destroy = destroyScene;
+    scene->suspend = NULL;
+    scene->resume = NULL;
+    scene->handleEvent = NULL;
+    scene->footprint = NULL;
+    scene->refreshRate = MENU_FPS;
+
+    PauseState* state = SYS->realloc(NULL, sizeof(PauseState));
+    state->endGameHandler = endGameHandler;
+    state->endGameData = data;
+    state->resumeRequested = false;
+    state->endGameRequested = false;
+
+    Form* form = formCreate();
+    state->form = form;
+
+    formFocus(form, formAddField(form, formCreateButtonField((Dimensions){ .x = BUTTON_X, .y = BUTTON_Y, .width = BUTTON_WIDTH, .height = BUTTON_HEIGHT }, "Resume", PAUSE_FONT_SIZE, PAUSE_FONT_SIZE, state, resumeHandler)));
+    formAddField(form, formCreateButtonField((Dimensions){ .x = BUTTON_X, .y = BUTTON_Y + BUTTON_HEIGHT + 12, .width = BUTTON_WIDTH, .height = BUTTON_HEIGHT }, "End Game", PAUSE_FONT_SIZE, PAUSE_FONT_SIZE, state, endGameHandler));
+
+    scene->data = (void*)state;
+
+    return scene;
+}
\ No newline at end of file
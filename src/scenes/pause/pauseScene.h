@@ -0,0 +1,12 @@
+#ifndef PAUSESCENE_H
+#define PAUSESCENE_H
+
+#include "scene.h"
+
+// Called when End Game is chosen, after the pause scene has been popped
+typedef void (*PauseSceneEndGameHandler)(void* data);
+
+// Create scene for the Pause overlay. It's pushed over a scene with gamePushScene and pops itself when closed
+Scene* pauseSceneCreate(PauseSceneEndGameHandler endGameHandler, void* data);
+
+#endif
\ No newline at end of file
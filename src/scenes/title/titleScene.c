@@ -48,8 +48,16 @@ Scene* titleSceneCreate(void) {
     Scene* scene = pd->system->realloc(NULL, sizeof(Scene));
     scene->name = "Title Screen";
     scene->init = initScene;
+    scene->prefetch = NULL;
     scene->update = updateScene;
     scene->destroy = destroyScene;
+    scene->suspend = NULL;
+    scene->resume = NULL;
+    scene->handleEvent = NULL;
+    scene->footprint = NULL;
+
+    // Nothing animates, the screen only waits for A to be pressed
+    scene->refreshRate = IDLE_FPS;
 
     return scene;
 }
\ No newline at end of file
@@ -1,69 +1,128 @@
 #include "asset.h"
 #include "global.h"
 #include "text.h"
+#include <stdio.h>
 #include "pd_api.h"
 
 #define FONT_PATH "fonts/public-pixel/PublicPixel-%dpt"
 
-typedef struct LoadedFont {
-   int points;
-   LCDFont* font;
-   struct LoadedFont* next;
-} LoadedFont;
+// Longest font path, including the terminator
+#define FONT_PATH_LENGTH 48
 
-static LoadedFont *loadedHead = NULL;
-static LoadedFont *loadedTail = NULL;
+// Loaded fonts indexed by point size. NULL for sizes that aren't loaded
+static LCDFont* fonts[TEXT_MAX_FONT_SIZE + 1] = { NULL };
+
+// Longest string that is kept in the cache. Longer strings are drawn directly
+#define TEXT_CACHE_MAX_LENGTH 31
+
+// Rendered string, kept in a list ordered from most to least recently drawn
+typedef struct CachedText {
+    char str[TEXT_CACHE_MAX_LENGTH + 1];
+    int fontSize;
+    TextColor textColor;
+
+    // Glyphs in the text color on a transparent background
+    LCDBitmap* bitmap;
+    int width;
+    int height;
+    // Approximate memory used by the bitmap and its mask
+    int bytes;
+
+    struct CachedText* prev;
+    struct CachedText* next;
+} CachedText;
+
+static CachedText* cacheHead = NULL;
+static CachedText* cacheTail = NULL;
+static int cacheBytes = 0;
+
+static CachedText* getCachedText(const char* str, int fontSize, TextColor textColor);
+static void drawTextDirect(LCDFont* font, const char* str, int x, int y, TextColor textColor);
+
+// Load the font for a size into the table
+static LCDFont* loadFont(int size) {
+    char path[FONT_PATH_LENGTH];
+    snprintf(path, sizeof(path), FONT_PATH, size);
+
+    fonts[size] = assetLoadFont(path);
+
+    return fonts[size];
+}
 
 // Return a reference to a font based on the size
 LCDFont* getFontForSize(int size) {
-    // Return font if it's already loaded
-    if (loadedHead != NULL) {
-        for (LoadedFont* current = loadedHead; current != NULL; current = current->next) {
-            if (current->points == size) {
-                return current->font;
-            }
-        }
+    if (size < 0 || size > TEXT_MAX_FONT_SIZE) {
+        return NULL;
     }
 
-    // If we're here then the font hasn't been loaded yet
-    char* path;
-    SYS->formatString(&path, FONT_PATH, size);
+    if (fonts[size] == NULL) {
+        // Scenes should preload their fonts so this doesn't hold up a frame
+        SYS->logToConsole("Loading %dpt font on demand", size);
 
-    LCDFont* font = assetLoadFont(path);
+        loadFont(size);
+    }
 
-    // Add the newly loaded font to the list
-    if (font != NULL) {
-        LoadedFont* loadedFont = SYS->realloc(NULL, sizeof(LoadedFont));
-        loadedFont->font = font;
-        loadedFont->points = size;
-        loadedFont->next = NULL;
-
-        if (loadedTail == NULL) {
-            loadedHead = loadedFont;
-            loadedTail = loadedFont;
-        } else {
-            loadedTail->next = loadedFont;
-            loadedTail = loadedFont;
+    return fonts[size];
+}
+
+// Load fonts for the given sizes ahead of when they're drawn
+void textPreloadFonts(const int* sizes, int numSizes) {
+    for (int i = 0; i < numSizes; i++) {
+        if (sizes[i] >= 0 && sizes[i] <= TEXT_MAX_FONT_SIZE && fonts[sizes[i]] == NULL) {
+            loadFont(sizes[i]);
         }
     }
+}
 
-    return font;
+// Whether the font for the given size is loaded
+bool textFontLoaded(int size) {
+    return size >= 0 && size <= TEXT_MAX_FONT_SIZE && fonts[size] != NULL;
+}
+
+// Free every loaded font that isn't one of the given sizes
+void textFreeFontsExcept(const int* sizes, int numSizes) {
+    for (int size = 0; size <= TEXT_MAX_FONT_SIZE; size++) {
+        bool keep = false;
+
+        for (int i = 0; i < numSizes; i++) {
+            if (sizes[i] == size) {
+                keep = true;
+            }
+        }
+
+        // Fonts are a single allocation and are freed the same way
+        if (!keep && fonts[size] != NULL) {
+            SYS->realloc(fonts[size], 0);
+            fonts[size] = NULL;
+        }
+    }
 }
 
 // Draw text on the screen at the given position
 void textDraw(const char* str, int x, int y, int fontSize, TextColor textColor) {
+    CachedText* cached = getCachedText(str, fontSize, textColor);
+
+    if (cached != NULL) {
+        GFX->drawBitmap(cached->bitmap, x, y, kBitmapUnflipped);
+        return;
+    }
+
     LCDFont* font = getFontForSize(fontSize);
 
     if (font != NULL) {
-        GFX->setFont(font);
-        GFX->setDrawMode(textColor == kTextColorBlack ? kDrawModeFillBlack : kDrawModeFillWhite);
-        GFX->drawText(str, strlen(str), kASCIIEncoding, x, y);
-        GFX->setDrawMode(kDrawModeCopy);
+        drawTextDirect(font, str, x, y, textColor);
     }
 }
 
 // Draw text on the screen in the given position centered within the bounds given
 void textDrawCentered(const char* str, int x, int y, int width, int height, int fontSize, TextColor textColor) {
+    CachedText* cached = getCachedText(str, fontSize, textColor);
+
+    if (cached != NULL) {
+        GFX->drawBitmap(cached->bitmap, x + (width / 2) - (cached->width / 2), y + (height / 2) - (cached->height / 2), kBitmapUnflipped);
+        return;
+    }
+
     LCDFont* font = getFontForSize(fontSize);
 
     if (font != NULL) {
@@ -75,13 +134,25 @@ void textDrawCentered(const char* str, int x, int y, int width, int height, int
         int centeredY = y + (height / 2) - (textHeight / 2);
 
         // Write the text
-        GFX->setFont(font);
-        GFX->setDrawMode(textColor == kTextColorBlack ? kDrawModeFillBlack : kDrawModeFillWhite);
-        GFX->drawText(str, strlen(str), kASCIIEncoding, centeredX, centeredY);
-        GFX->setDrawMode(kDrawModeCopy);
+        drawTextDirect(font, str, centeredX, centeredY, textColor);
     }
 }
 
+// Free every rendered string in the cache
+void textCacheClear(void) {
+    while (cacheHead != NULL) {
+        CachedText* next = cacheHead->next;
+
+        GFX->freeBitmap(cacheHead->bitmap);
+        SYS->realloc(cacheHead, 0);
+
+        cacheHead = next;
+    }
+
+    cacheTail = NULL;
+    cacheBytes = 0;
+}
+
 // Get draw height of text in font used by the given font size
 int textHeight(int fontSize) {
     LCDFont* font = getFontForSize(fontSize);
@@ -94,4 +165,118 @@ int textWidth(const char *str, size_t len, int fontSize) {
     LCDFont* font = getFontForSize(fontSize);
 
     return GFX->getTextWidth(font, str, len, kASCIIEncoding, 0);
+}
+
+// Draw text with the font's glyphs in the text color
+static void drawTextDirect(LCDFont* font, const char* str, int x, int y, TextColor textColor) {
+    GFX->setFont(font);
+    GFX->setDrawMode(textColor == kTextColorBlack ? kDrawModeFillBlack : kDrawModeFillWhite);
+    GFX->drawText(str, strlen(str), kASCIIEncoding, x, y);
+    GFX->setDrawMode(kDrawModeCopy);
+}
+
+// Move a cached string to the front of the list
+static void touchCachedText(CachedText* cached) {
+    if (cached == cacheHead) {
+        return;
+    }
+
+    cached->prev->next = cached->next;
+
+    if (cached->next != NULL) {
+        cached->next->prev = cached->prev;
+    } else {
+        cacheTail = cached->prev;
+    }
+
+    cached->prev = NULL;
+    cached->next = cacheHead;
+    cacheHead->prev = cached;
+    cacheHead = cached;
+}
+
+// Free the least recently drawn string
+static void evictCachedText(void) {
+    CachedText* evicted = cacheTail;
+
+    cacheTail = evicted->prev;
+
+    if (cacheTail != NULL) {
+        cacheTail->next = NULL;
+    } else {
+        cacheHead = NULL;
+    }
+
+    cacheBytes -= evicted->bytes;
+
+    GFX->freeBitmap(evicted->bitmap);
+    SYS->realloc(evicted, 0);
+}
+
+// Return the rendered bitmap of a string, rendering it if it isn't cached
+// Returns NULL if the string can't be cached
+static CachedText* getCachedText(const char* str, int fontSize, TextColor textColor) {
+    size_t len = strlen(str);
+
+    if (len == 0 || len > TEXT_CACHE_MAX_LENGTH) {
+        return NULL;
+    }
+
+    for (CachedText* current = cacheHead; current != NULL; current = current->next) {
+        if (current->fontSize == fontSize && current->textColor == textColor && strcmp(current->str, str) == 0) {
+            touchCachedText(current);
+            return current;
+        }
+    }
+
+    LCDFont* font = getFontForSize(fontSize);
+
+    if (font == NULL) {
+        return NULL;
+    }
+
+    int width = GFX->getTextWidth(font, str, len, kASCIIEncoding, 0);
+    int height = GFX->getFontHeight(font);
+    // Rows are padded to 32 bits and the mask is the same size as the image
+    int bytes = ((width + 31) / 32) * 4 * height * 2;
+
+    if (width <= 0 || height <= 0 || bytes > TEXT_CACHE_BYTES) {
+        return NULL;
+    }
+
+    while (cacheHead != NULL && cacheBytes + bytes > TEXT_CACHE_BYTES) {
+        evictCachedText();
+    }
+
+    LCDBitmap* bitmap = GFX->newBitmap(width, height, kColorClear);
+
+    if (bitmap == NULL) {
+        return NULL;
+    }
+
+    GFX->pushContext(bitmap);
+    drawTextDirect(font, str, 0, 0, textColor);
+    GFX->popContext();
+
+    CachedText* cached = SYS->realloc(NULL, sizeof(CachedText));
+    memcpy(cached->str, str, len + 1);
+    cached->fontSize = fontSize;
+    cached->textColor = textColor;
+    cached->bitmap = bitmap;
+    cached->width = width;
+    cached->height = height;
+    cached->bytes = bytes;
+    cached->prev = NULL;
+    cached->next = cacheHead;
+
+    if (cacheHead != NULL) {
+        cacheHead->prev = cached;
+    } else {
+        cacheTail = cached;
+    }
+
+    cacheHead = cached;
+    cacheBytes += bytes;
+
+    return cached;
 }
\ No newline at end of file
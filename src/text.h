@@ -1,19 +1,46 @@
 #ifndef TEXT_H
 #define TEXT_H
 
+#include "pd_api.h"
+#include <stdbool.h>
+
 #define DEFAULT_FONT_SIZE 8
 
+// Largest point size of the available fonts
+#define TEXT_MAX_FONT_SIZE 18
+
+// Memory allowed for rendered strings kept by textDraw and textDrawCentered
+#ifndef TEXT_CACHE_BYTES
+#define TEXT_CACHE_BYTES (16 * 1024)
+#endif
+
 typedef enum TextColor {
     kTextColorBlack,
     kTextColorWhite
 } TextColor;
 
+// Get the font used by the given font size, loading it if needed
+LCDFont* getFontForSize(int size);
+
+// Load fonts for the given sizes ahead of when they're drawn
+// Called while a scene starts so no font is loaded from disk during play
+void textPreloadFonts(const int* sizes, int numSizes);
+
+// Whether the font for the given size is loaded
+bool textFontLoaded(int size);
+
+// Free every loaded font that isn't one of the given sizes
+void textFreeFontsExcept(const int* sizes, int numSizes);
+
 // Draw text on the screen at the given position
 void textDraw(const char* str, int x, int y, int fontSize, TextColor textColor);
 
 // Draw text on the screen in the given position centered within the bounds given
 void textDrawCentered(const char* str, int x, int y, int width, int height, int fontSize, TextColor textColor);
 
+// Free every rendered string kept by textDraw and textDrawCentered
+void textCacheClear(void);
+
 // Get draw height of text in font used by the given font size
 int textHeight(int fontSize);
 